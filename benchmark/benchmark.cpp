@@ -0,0 +1,343 @@
+///@file benchmark.cpp
+///@brief Sweeps every operator over population sizes, tournament sizes, genome lengths and genesLoci densities, and writes one JSON or CSV record per measurement
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+#include <genetic-algorithm.hpp>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+//Every allocation of the process goes through these, the library's included
+std::atomic<uint64_t> allocations{0};
+
+void* operator new(size_t size){
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if(void *p = std::malloc(size ? size : 1)){
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept{
+    std::free(p);
+}
+
+void* operator new[](size_t size){
+    return operator new(size);
+}
+
+void operator delete[](void *p) noexcept{
+    std::free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept{
+    std::free(p);
+}
+
+//Counts the cache misses of the calling thread through perf_event_open, when the kernel lets us
+class CacheMissCounter{
+public:
+    CacheMissCounter(){
+#ifdef __linux__
+        perf_event_attr attributes;
+        std::memset(&attributes, 0, sizeof(attributes));
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.size = sizeof(attributes);
+        attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+        attributes.disabled = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        descriptor = int(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+#endif
+    }
+
+    ~CacheMissCounter(){
+#ifdef __linux__
+        if(descriptor>=0){
+            close(descriptor);
+        }
+#endif
+    }
+
+    bool available() const { return descriptor>=0; }
+
+    void start(){
+#ifdef __linux__
+        if(descriptor>=0){
+            ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+            ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    //Returns -1 if the counter isn't available
+    long long stop(){
+#ifdef __linux__
+        if(descriptor>=0){
+            ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+            long long count = 0;
+            if(read(descriptor, &count, sizeof(count))==sizeof(count)){
+                return count;
+            }
+        }
+#endif
+        return -1;
+    }
+
+private:
+    int descriptor = -1;
+};
+
+struct Options{
+    std::vector<long long> populationSizes = {1000, 10000, 100000, 1000000, 10000000};
+    std::vector<double> winnersRatios = {1.};
+    std::vector<int> tournamentSizes = {2, 4, 8};
+    std::vector<long long> genomeLengths = {64, 4096, 102400};
+    std::vector<double> lociDensities = {0.25, 0.0625};
+    double minimumSeconds = 0.2;
+    uint64_t seed = 42;
+    bool csv = false;
+    const char *output = NULL;
+};
+
+struct Measurement{
+    const char *operation;
+    long long populationSize;
+    long long winnersSize;
+    int tournamentSize;
+    long long genomeLength;
+    double lociDensity;
+    const char *unit;
+    double nsPerUnit;
+    double allocationsPerCall;
+    double cacheMissesPerCall;
+};
+
+//Calls operation until minimumSeconds have passed, after one warm up call that isn't measured
+Measurement measure(const Options &options, CacheMissCounter &counter, const std::function<void()> &operation, double unitsPerCall){
+    operation();
+    long long calls = 0;
+    uint64_t allocationsBefore = allocations.load();
+    counter.start();
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    do{
+        operation();
+        ++calls;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while(elapsed<options.minimumSeconds);
+    long long misses = counter.stop();
+    Measurement measurement = {};
+    measurement.nsPerUnit = elapsed*1e9/(double(calls)*unitsPerCall);
+    measurement.allocationsPerCall = double(allocations.load() - allocationsBefore)/calls;
+    measurement.cacheMissesPerCall = misses>=0 ? double(misses)/calls : -1;
+    return measurement;
+}
+
+void writeHeader(FILE *file, const Options &options){
+    if(options.csv){
+        std::fprintf(file, "operation,population_size,winners_size,tournament_size,genome_length,loci_density,unit,ns_per_unit,allocations_per_call,cache_misses_per_call\n");
+    }
+}
+
+void writeMeasurement(FILE *file, const Options &options, const Measurement &m){
+    if(options.csv){
+        std::fprintf(file, "%s,%lld,%lld,%d,%lld,%g,%s,%.4f,%.3f,%.1f\n", m.operation, m.populationSize, m.winnersSize, m.tournamentSize, m.genomeLength, m.lociDensity, m.unit, m.nsPerUnit, m.allocationsPerCall, m.cacheMissesPerCall);
+    } else {
+        std::fprintf(file, "{\"operation\":\"%s\",\"population_size\":%lld,\"winners_size\":%lld,\"tournament_size\":%d,\"genome_length\":%lld,\"loci_density\":%g,\"unit\":\"%s\",\"ns_per_unit\":%.4f,\"allocations_per_call\":%.3f,\"cache_misses_per_call\":%.1f}\n",
+                m.operation, m.populationSize, m.winnersSize, m.tournamentSize, m.genomeLength, m.lociDensity, m.unit, m.nsPerUnit, m.allocationsPerCall, m.cacheMissesPerCall);
+    }
+    std::fflush(file);
+}
+
+template<typename T>
+std::vector<T> parseList(const char *text){
+    std::vector<T> values;
+    for(const char *p=text;*p;){
+        char *end;
+        values.push_back(T(std::strtod(p, &end)));
+        p = *end ? end + 1 : end;
+    }
+    return values;
+}
+
+void usage(const char *program){
+    std::fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --populations LIST       Population sizes, default 1e3,1e4,1e5,1e6,1e7\n"
+        "  --winners-ratios LIST    winnersSize as a fraction of populationSize, default 1\n"
+        "  --tournament-sizes LIST  Default 2,4,8\n"
+        "  --genome-lengths LIST    In bytes, default 64,4096,102400\n"
+        "  --loci-densities LIST    Fraction of bytes that start a gene, default 0.25,0.0625\n"
+        "  --min-time SECONDS       Minimum measuring time of each point, default 0.2\n"
+        "  --seed N                 Default 42\n"
+        "  --csv                    Write CSV instead of JSON lines\n"
+        "  --output FILE            Default standard output\n", program);
+}
+
+bool parseOptions(int argc, char **argv, Options &options){
+    for(int i=1;i<argc;++i){
+        std::string option = argv[i];
+        if(option=="--csv"){
+            options.csv = true;
+            continue;
+        }
+        if(i + 1>=argc){
+            return false;
+        }
+        const char *value = argv[++i];
+        if(option=="--populations"){
+            options.populationSizes = parseList<long long>(value);
+        } else if(option=="--winners-ratios"){
+            options.winnersRatios = parseList<double>(value);
+        } else if(option=="--tournament-sizes"){
+            options.tournamentSizes = parseList<int>(value);
+        } else if(option=="--genome-lengths"){
+            options.genomeLengths = parseList<long long>(value);
+        } else if(option=="--loci-densities"){
+            options.lociDensities = parseList<double>(value);
+        } else if(option=="--min-time"){
+            options.minimumSeconds = std::strtod(value, NULL);
+        } else if(option=="--seed"){
+            options.seed = std::strtoull(value, NULL, 10);
+        } else if(option=="--output"){
+            options.output = value;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+void benchmarkSelection(const Options &options, CacheMissCounter &counter, FILE *file, RandomEngine &engine){
+    for(long long populationSize : options.populationSizes){
+        std::vector<float> fitness(populationSize);
+        for(float &f : fitness){
+            f = engine.uniformFloat();
+        }
+        for(double ratio : options.winnersRatios){
+            int winnersSize = std::max(1, int(populationSize*ratio));
+            std::vector<int> winners(winnersSize);
+            int n = int(populationSize);
+            Measurement m;
+            m = measure(options, counter, [&]{ rouletteRanking(n, fitness.data(), winners.data(), winnersSize, engine); }, winnersSize);
+            m.operation = "rouletteRanking";
+            m.populationSize = populationSize; m.winnersSize = winnersSize; m.unit = "winner";
+            writeMeasurement(file, options, m);
+            m = measure(options, counter, [&]{ rouletteRanking(n, fitness.data(), winners.data(), winnersSize, engine, SamplingMethod::Universal); }, winnersSize);
+            m.operation = "rouletteRanking/universal";
+            m.populationSize = populationSize; m.winnersSize = winnersSize; m.unit = "winner";
+            writeMeasurement(file, options, m);
+            m = measure(options, counter, [&]{ linearRanking(n, fitness.data(), true, 1.5f, winners.data(), winnersSize, engine); }, winnersSize);
+            m.operation = "linearRanking";
+            m.populationSize = populationSize; m.winnersSize = winnersSize; m.unit = "winner";
+            writeMeasurement(file, options, m);
+            m = measure(options, counter, [&]{ linearRanking(n, fitness.data(), true, 1.5f, winners.data(), winnersSize, engine, SamplingMethod::Universal); }, winnersSize);
+            m.operation = "linearRanking/universal";
+            m.populationSize = populationSize; m.winnersSize = winnersSize; m.unit = "winner";
+            writeMeasurement(file, options, m);
+            m = measure(options, counter, [&]{ exponentialRanking(n, fitness.data(), true, 0.05f, winners.data(), winnersSize, engine); }, winnersSize);
+            m.operation = "exponentialRanking";
+            m.populationSize = populationSize; m.winnersSize = winnersSize; m.unit = "winner";
+            writeMeasurement(file, options, m);
+            for(int tournamentSize : options.tournamentSizes){
+                if(tournamentSize>=populationSize){
+                    continue;
+                }
+                m = measure(options, counter, [&]{ tournamentRanking(n, fitness.data(), true, tournamentSize, winners.data(), winnersSize, engine); }, winnersSize);
+                m.operation = "tournamentRanking";
+                m.populationSize = populationSize; m.winnersSize = winnersSize; m.tournamentSize = tournamentSize; m.unit = "winner";
+                writeMeasurement(file, options, m);
+            }
+        }
+    }
+}
+
+void benchmarkReproduction(const Options &options, CacheMissCounter &counter, FILE *file, RandomEngine &engine){
+    for(long long genomeLength : options.genomeLengths){
+        uint64_t length = uint64_t(genomeLength);
+        std::vector<uint8_t> parent1(length), parent2(length), child(length);
+        for(uint64_t i=0;i<length;++i){
+            parent1[i] = uint8_t(engine());
+            parent2[i] = uint8_t(engine());
+        }
+        Measurement m;
+        m = measure(options, counter, [&]{ twoPointsCrossover(parent1.data(), parent2.data(), length, child.data(), engine); }, length);
+        m.operation = "twoPointsCrossover";
+        m.genomeLength = genomeLength; m.unit = "byte";
+        writeMeasurement(file, options, m);
+        m = measure(options, counter, [&]{ uniformCrossover(parent1.data(), parent2.data(), length, child.data(), engine); }, length);
+        m.operation = "uniformCrossover";
+        m.genomeLength = genomeLength; m.unit = "byte";
+        writeMeasurement(file, options, m);
+        m = measure(options, counter, [&]{ mutate(child.data(), int(length), 0.001f, engine); }, length);
+        m.operation = "mutate";
+        m.genomeLength = genomeLength; m.unit = "byte";
+        writeMeasurement(file, options, m);
+        for(double density : options.lociDensities){
+            //Genes of 1/density bytes, extremes included
+            uint64_t geneLength = std::max<uint64_t>(1, uint64_t(1./density));
+            std::vector<uint64_t> genesLoci;
+            for(uint64_t locus=0;locus<length;locus+=geneLength){
+                genesLoci.push_back(locus);
+            }
+            genesLoci.push_back(length);
+            int lociLength = int(genesLoci.size());
+            if(lociLength<3){
+                continue;
+            }
+            m = measure(options, counter, [&]{ twoPointsCrossover(parent1.data(), parent2.data(), length, child.data(), genesLoci.data(), lociLength, engine); }, length);
+            m.operation = "twoPointsCrossover";
+            m.genomeLength = genomeLength; m.lociDensity = density; m.unit = "byte";
+            writeMeasurement(file, options, m);
+            m = measure(options, counter, [&]{ uniformCrossover(parent1.data(), parent2.data(), length, child.data(), genesLoci.data(), lociLength, engine); }, length);
+            m.operation = "uniformCrossover";
+            m.genomeLength = genomeLength; m.lociDensity = density; m.unit = "byte";
+            writeMeasurement(file, options, m);
+            m = measure(options, counter, [&]{ mutate(child.data(), length, genesLoci.data(), lociLength, 0.001f, engine); }, length);
+            m.operation = "mutate";
+            m.genomeLength = genomeLength; m.lociDensity = density; m.unit = "byte";
+            writeMeasurement(file, options, m);
+        }
+    }
+}
+
+int main(int argc, char **argv){
+    Options options;
+    if(!parseOptions(argc, argv, options)){
+        usage(argv[0]);
+        return 1;
+    }
+    FILE *file = options.output ? std::fopen(options.output, "w") : stdout;
+    if(!file){
+        std::perror(options.output);
+        return 1;
+    }
+    CacheMissCounter counter;
+    if(!counter.available()){
+        std::fprintf(stderr, "Cache misses aren't available, they'll be reported as -1\n");
+    }
+    RandomEngine engine(options.seed);
+    writeHeader(file, options);
+    benchmarkSelection(options, counter, file, engine);
+    benchmarkReproduction(options, counter, file, engine);
+    if(file!=stdout){
+        std::fclose(file);
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+#pragma once
+///@file checkpoint.hpp
+///@brief Saving the whole state of a generational loop to a file, in the background, and resuming from it bit for bit
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fitness-cache.hpp>
+#include <population.hpp>
+#include <random-engine.hpp>
+
+/*!
+ * @brief What a generational loop needs to resume where it was: the genomes and fitnesses of the current generation, every random engine it draws from and the fitness cache. A run that restores it and goes on makes the same draws, and so the same generations, as the run that saved it
+ * The selection tables of selectionTableCache aren't part of it: they only depend on their parameters, so rebuilding them doesn't change the run. Neither is the engine of the overloads that don't take one, unless &defaultRandomEngine() is among the engines
+ */
+struct GenerationState{
+    uint64_t generation = 0;                ///< The number of generations run so far
+    Population *population = nullptr;       ///< The population, whose current generation is saved
+    float *fitness = nullptr;               ///< Array of population->size() elements, the fitness of each individual. Can be null
+    std::vector<RandomEngine*> engines;     ///< The engines the run draws from
+    FitnessCache *cache = nullptr;          ///< The cache the fitnesses are memoized in. Can be null
+};
+
+/*!
+ * @brief Writes state to path. The file is written next to path and renamed over it once complete, so path always holds either the previous checkpoint or this one
+ * The format is a header, the engines, the fitnesses, the genomes without their padding and the cache's occupied slots, in the machine's byte order, followed by a checksum
+ * @throw std::system_error if the file can't be written
+ */
+void saveCheckpoint(const std::string &path, const GenerationState &state);
+
+/*!
+ * @brief Restores the objects state points to from the checkpoint at path, and sets state.generation. They must have the same shape as when it was saved: the population's size and genome length, the number of engines, whether there are fitnesses and the cache's capacity
+ * @throw std::system_error if the file can't be read, std::runtime_error if it isn't a checkpoint, is corrupted or doesn't match state. The genomes may have been overwritten by then, but nothing else is
+ */
+void loadCheckpoint(const std::string &path, GenerationState &state);
+
+struct CheckpointImage;
+
+/*!
+ * @brief Writes checkpoints on a background thread, so that the generational loop doesn't wait for the disk. Each write copies the engines, the fitnesses and the cache right away, and pins the genomes, see Population::pin, which are read from the population's arenas without being copied however many generations the write takes
+ * One write is in flight at a time: a write waits for the previous one
+ */
+class CheckpointWriter{
+public:
+    CheckpointWriter();
+
+    /*!
+     * @brief Waits for the write in flight. Its errors are dropped, call wait() first to get them
+     */
+    ~CheckpointWriter();
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    /*!
+     * @brief Starts writing state to path, as saveCheckpoint does, and returns once the state is captured
+     * @throw std::system_error if the previous write failed
+     */
+    void write(const std::string &path, const GenerationState &state);
+
+    /*!
+     * @brief Waits until the write in flight, if any, is complete
+     * @throw std::system_error if it failed
+     */
+    void wait();
+
+    /*!
+     * @brief Whether a write is in flight
+     */
+    bool busy() const;
+
+private:
+    void writerLoop();
+
+    std::unique_ptr<CheckpointImage> image;     ///< Reused by every write, so that its buffers are only allocated once
+    std::string path;
+    std::thread writer;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::exception_ptr error;
+    bool pending = false;
+    bool stopping = false;
+};
@@ -0,0 +1,98 @@
+#pragma once
+///@file fitness-cache.hpp
+///@brief Memoization of fitnesses by genome hash, so that duplicate genomes are only evaluated once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/*!
+ * @brief 64 bits hash of a genome, built like XXH3: 64 bytes stripes go through 8 multiply-accumulate lanes, vectorized with AVX2 or SSE2 when available, and the lanes are scrambled every 1 KiB and merged at the end. It isn't XXH3 itself, so its values don't match any other implementation's
+ * @param[in]   genome  The genome to hash
+ * @param[in]   length  The length in bytes of genome
+ */
+uint64_t genomeHash(const uint8_t *genome, uint64_t length);
+
+/*!
+ * @brief An occupied slot of a FitnessCache, as saved in a checkpoint
+ */
+struct FitnessCacheEntry{
+    uint64_t slot;
+    uint64_t hash;
+    float fitness;
+};
+
+/*!
+ * @brief Bounded map from genome hash to fitness. It's a lossy cache: a set-associative table of fixed size where a new entry evicts an old one when its set is full, so it never allocates after construction
+ * Lookups and insertions are lock-free and can be made by any number of threads at once. An entry being overwritten while it's looked up reads as a miss, never as a wrong fitness
+ * @note Two genomes with the same hash share their fitness. With 64 bits hashes, that's unlikely to happen before billions of distinct genomes
+ */
+class FitnessCache{
+public:
+    /*!
+     * @param[in]   capacity    The number of fitnesses kept, rounded up to a power of 2 of at least 4
+     */
+    explicit FitnessCache(uint64_t capacity);
+
+    /*!
+     * @brief Looks up the fitness of the genome whose genomeHash is hash
+     * @param[in]   hash    The genome's hash
+     * @param[out]  fitness The cached fitness, only written on a hit
+     * @return Whether the fitness was cached
+     */
+    bool find(uint64_t hash, float &fitness) const;
+
+    /*!
+     * @brief Caches the fitness of the genome whose genomeHash is hash
+     */
+    void insert(uint64_t hash, float fitness);
+
+    /*!
+     * @brief Drops every entry, e.g. when the fitness function changes. Must not be called concurrently with anything else
+     */
+    void clear();
+
+    /*!
+     * @brief Appends every cached fitness, with the slot it's in, to entries. Must not be called concurrently with insert
+     */
+    void save(std::vector<FitnessCacheEntry> &entries) const;
+
+    /*!
+     * @brief Replaces the contents of the cache with entries saved from a cache of the same capacity, each in the slot it was in, so that later evictions happen as they would have in that cache. Must not be called concurrently with anything else
+     */
+    void restore(const FitnessCacheEntry *entries, uint64_t count);
+
+    uint64_t capacity() const { return (mask + 1)*bucketSlots; }
+
+private:
+    static const int bucketSlots = 4;
+
+    //The key is the hash, 0 for an empty slot. The entry packs the high half of the hash, to detect torn updates, with the fitness' bits
+    struct Slot{
+        std::atomic<uint64_t> key;
+        std::atomic<uint64_t> entry;
+    };
+    struct alignas(64) Bucket{
+        Slot slots[bucketSlots];
+    };
+
+    std::unique_ptr<Bucket[]> buckets;
+    uint64_t mask;
+};
+
+/*!
+ * @brief What reproduce and evaluateFitness exchange to skip the genomes whose fitness is already known. Size it once for the population and reuse it every generation
+ */
+struct FitnessMemo{
+    /*!
+     * @param[in]   cache           The cache the fitnesses are looked up in and added to, shared by any number of memos
+     * @param[in]   populationSize  The number of individuals
+     */
+    FitnessMemo(FitnessCache &cache, int populationSize);
+
+    FitnessCache *cache;
+    std::vector<uint64_t> hashes;       ///< The genomeHash of each individual
+    std::vector<uint8_t> known;         ///< 1 for the individuals whose fitness was found in the cache, 0 for those that need evaluating
+    std::vector<int> novel;             ///< Scratch space for evaluateFitness, the individuals to evaluate
+    std::vector<int> distinct;          ///< Scratch space for evaluateFitness, one individual per distinct novel genome
+};
@@ -0,0 +1,124 @@
+#pragma once
+///@file fitness-index.hpp
+///@brief Order-statistics index of a population's fitnesses, for steady-state algorithms that only replace a few individuals per step
+#include <cstdint>
+#include <vector>
+#include <random-engine.hpp>
+#include <selection-distribution.hpp>
+#include <selection-workspace.hpp>
+
+/*!
+ * @brief Keeps the individuals of a population ordered by fitness, in the same order rankPopulation produces, under insertions, replacements and removals that each cost O(log N). Any rank can then be looked up in O(log N), so the rank-based selections can sample from it without re-sorting
+ * It's a treap whose nodes are the individuals' indices: it allocates once, at construction, for capacity individuals
+ * @note An index must not be modified concurrently with any other call, but can be sampled by any number of threads at once
+ */
+class FitnessIndex{
+public:
+    /*!
+     * @param[in]   capacity        The number of individuals, indices go from 0 to capacity-1
+     * @param[in]   maximizeFitness True if the objective is to maximize fitness, False otherwise
+     */
+    FitnessIndex(int capacity, bool maximizeFitness);
+
+    /*!
+     * @brief Replaces the whole content of the index with the first populationSize individuals, in O(N log N) but without the per-insertion overhead
+     * @param[in]   fitness         Array to the fitnesses of each individual
+     * @param[in]   populationSize  The number of individuals, no more than capacity()
+     */
+    void assign(const float *fitness, int populationSize);
+
+    /*!
+     * @brief Adds individual to the index. It must not be in it already
+     */
+    void insert(int individual, float fitness);
+
+    /*!
+     * @brief Removes individual from the index. It must be in it
+     */
+    void remove(int individual);
+
+    /*!
+     * @brief Changes the fitness of individual, which must be in the index, as when it's replaced by a new child
+     */
+    void replace(int individual, float fitness);
+
+    bool contains(int individual) const { return nodes[individual].size!=0; }
+
+    /*!
+     * @brief The fitness individual was inserted with. It must be in the index
+     */
+    float fitness(int individual) const { return fitnesses[individual]; }
+
+    /*!
+     * @brief The individual at rank, the best one being at rank 0. rank must be less than size()
+     */
+    int individualAt(int rank) const;
+
+    /*!
+     * @brief The rank of individual, which must be in the index
+     */
+    int rankOf(int individual) const;
+
+    int size() const { return root<0 ? 0 : nodes[root].size; }
+    int capacity() const { return int(nodes.size()); }
+    bool maximizeFitness() const { return maximize; }
+
+private:
+    struct Node{
+        uint64_t key;           ///< The individual's rankingKey
+        uint32_t priority;
+        int size;               ///< The size of the subtree, 0 when the individual isn't in the index
+        int left;
+        int right;
+    };
+
+    void update(int node);
+    void split(int tree, uint64_t key, int &less, int &notLess);
+    int merge(int less, int greater);
+
+    std::vector<Node> nodes;
+    std::vector<float> fitnesses;
+    int root = -1;
+    bool maximize;
+    RandomEngine priorities;
+    std::vector<int> spine;         ///< Scratch space for assign, the right spine of the treap being built
+    SelectionWorkspace workspace;   ///< Scratch space for assign, to rank the population
+};
+
+/*!
+ * @brief Same as linearRanking, but samples the ranks out of index instead of ranking a fitness array. Costs O(log N) per winner, plus building the table the first time index.size() is seen
+ * @param[in]       index               The individuals to pick from
+ * @param[in]       selectionPressure   Determines how much each rank weighs
+ * @param[out]      winners             Array that will be filled with the indices of the picked winners
+ * @param[in]       winnersSize         The desired number of winners
+ * @param[in,out]   engine              The random engine to draw from
+ * @param[in]       method              How the ranks are drawn, see SamplingMethod
+ */
+void linearRanking(const FitnessIndex &index, float selectionPressure, int *winners, int winnersSize, RandomEngine &engine, SamplingMethod method = SamplingMethod::Automatic);
+
+/*!
+ * @brief Same as exponentialRanking, but samples the ranks out of index instead of ranking a fitness array. Costs O(log N) per winner, plus building the table the first time index.size() is seen
+ * @param[in]       index       The individuals to pick from
+ * @param[in]       k1          Determines how much each rank weighs
+ * @param[out]      winners     Array that will be filled with the indices of the picked winners
+ * @param[in]       winnersSize The desired number of winners
+ * @param[in,out]   engine      The random engine to draw from
+ * @param[in]       method      How the ranks are drawn, see SamplingMethod
+ */
+void exponentialRanking(const FitnessIndex &index, float k1, int *winners, int winnersSize, RandomEngine &engine, SamplingMethod method = SamplingMethod::Automatic);
+
+/*!
+ * @brief Same as tournamentRanking, but draws tournamentSize distinct ranks out of index and picks the individual at the lowest one. Costs O(tournamentSize^2 + log N) per winner
+ * @param[in]       index           The individuals to pick from
+ * @param[in]       tournamentSize  Determines the size of each tournament
+ * @param[out]      winners         Array that will be filled with the indices of the picked winners
+ * @param[in]       winnersSize     The desired number of winners
+ * @param[in,out]   workspace       The scratch memory to use
+ * @param[in,out]   engine          The random engine to draw from
+ */
+void tournamentRanking(const FitnessIndex &index, int tournamentSize, int *winners, int winnersSize, SelectionWorkspace &workspace, RandomEngine &engine);
+
+/*!
+ * @brief Same as above, but takes its scratch memory from the thread's default workspace
+ */
+void tournamentRanking(const FitnessIndex &index, int tournamentSize, int *winners, int winnersSize, RandomEngine &engine);
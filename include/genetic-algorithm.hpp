@@ -2,6 +2,16 @@
 ///@file genetic-algorithm.hpp
 ///@brief Library that provides a variety of genetic algorithms
 #include <cstdint>
+#include <fitness-index.hpp>
+#include <genome-layout.hpp>
+#include <instrumentation.hpp>
+#include <multi-objective.hpp>
+#include <random-engine.hpp>
+#include <ranking.hpp>
+#include <real-operators.hpp>
+#include <selection-distribution.hpp>
+#include <selection-table-cache.hpp>
+#include <selection-workspace.hpp>
 
 /*!
  * @brief Picks winners based on a roulette wheel whose sectors' widths are proportional to the fitness of each individual
@@ -12,6 +22,34 @@
  */
 void rouletteRanking(int populationSize, float *fitness, int *winners, int winnersSize);
 
+/*!
+ * @brief Same as above, but draws its random numbers from engine instead of the thread's default one
+ * @param[in,out]  engine  The random engine to draw from
+ * @param[in]      method  How the winners are drawn, see SamplingMethod
+ */
+void rouletteRanking(int populationSize, float *fitness, int *winners, int winnersSize, RandomEngine &engine, SamplingMethod method = SamplingMethod::Automatic);
+
+/*!
+ * @brief Same as above, but takes its scratch memory from workspace, so that it doesn't allocate as long as populationSize doesn't exceed workspace.capacity()
+ * @param[in,out]  workspace   The scratch memory to use
+ */
+void rouletteRanking(int populationSize, float *fitness, int *winners, int winnersSize, SelectionWorkspace &workspace, RandomEngine &engine, SamplingMethod method = SamplingMethod::Automatic);
+
+/*!
+ * @brief Builds the roulette wheel used by rouletteRanking, so that it can be sampled many times
+ * @param[in]   populationSize  The number of individuals
+ * @param[in]   fitness         Array to the fitnesses of each individual
+ * @param[in]   method          The sampling method, must not be Automatic
+ * @param[out]  distribution    The distribution over the individuals' indices
+ */
+void rouletteDistribution(int populationSize, float *fitness, SamplingMethod method, SelectionDistribution &distribution);
+
+/*!
+ * @brief Same as above, but builds the distribution into workspace.distribution without allocating
+ * @param[in,out]  workspace   The scratch memory to use
+ */
+void rouletteDistribution(int populationSize, float *fitness, SamplingMethod method, SelectionWorkspace &workspace);
+
 /*!
  * @brief Picks winners based on a roulette wheel whose sectors' width is based on the ranks of the individuals, with selectionPressure acting as a parameter to determine how much rank weighs.
  * The formula used is P(r) = k1 - r*k2 where r=rank, k1= selectionPressure/populationSize and k2=selectionPressure/(populationSize*(populationSize-1))
@@ -24,6 +62,36 @@ void rouletteRanking(int populationSize, float *fitness, int *winners, int winne
  */
 void linearRanking(int populationSize, float *fitness, bool maximizeFitness, float selectionPressure, int *winners, int winnersSize);
 
+/*!
+ * @brief Same as above, but draws its random numbers from engine instead of the thread's default one
+ * @param[in,out]  engine  The random engine to draw from
+ * @param[in]      method  How the winners are drawn, see SamplingMethod
+ */
+void linearRanking(int populationSize, float *fitness, bool maximizeFitness, float selectionPressure, int *winners, int winnersSize, RandomEngine &engine, SamplingMethod method = SamplingMethod::Automatic);
+
+/*!
+ * @brief Same as above, but takes its scratch memory from workspace, so that it doesn't allocate as long as populationSize doesn't exceed workspace.capacity()
+ * @param[in,out]  workspace   The scratch memory to use
+ */
+void linearRanking(int populationSize, float *fitness, bool maximizeFitness, float selectionPressure, int *winners, int winnersSize, SelectionWorkspace &workspace, RandomEngine &engine, SamplingMethod method = SamplingMethod::Automatic);
+
+/*!
+ * @brief Builds the distribution over ranks used by linearRanking, so that it can be sampled many times. Rank 0 is the best individual
+ * @param[in]   selectionPressure   Determines how much each rank weighs
+ * @param[in]   populationSize      The number of individuals
+ * @param[in]   method              The sampling method, must not be Automatic
+ * @param[out]  distribution        The distribution over the ranks
+ */
+void linearRankingDistribution(float selectionPressure, int populationSize, SamplingMethod method, SelectionDistribution &distribution);
+
+/*!
+ * @brief Returns the table built by linearRankingDistribution out of selectionTableCache(), building it only if it isn't cached
+ * @param[in]   selectionPressure   Determines how much each rank weighs
+ * @param[in]   populationSize      The number of individuals
+ * @param[in]   method              The sampling method, must not be Automatic
+ */
+SelectionTableCache::Table linearRankingTable(float selectionPressure, int populationSize, SamplingMethod method);
+
 /*!
  * @brief Picks winners based on a roulette wheel whose sectors' width is based on the ranks of the individuals, with k1 acting as a parameter to determine how much rank weighs.
  * The formula used is P(r) = k1*(1-k1)^r where r=rank
@@ -36,6 +104,36 @@ void linearRanking(int populationSize, float *fitness, bool maximizeFitness, flo
  */
 void exponentialRanking(int populationSize, float *fitness, bool maximizeFitness, float k1, int *winners, int winnersSize);
 
+/*!
+ * @brief Same as above, but draws its random numbers from engine instead of the thread's default one
+ * @param[in,out]  engine  The random engine to draw from
+ * @param[in]      method  How the winners are drawn, see SamplingMethod
+ */
+void exponentialRanking(int populationSize, float *fitness, bool maximizeFitness, float k1, int *winners, int winnersSize, RandomEngine &engine, SamplingMethod method = SamplingMethod::Automatic);
+
+/*!
+ * @brief Same as above, but takes its scratch memory from workspace, so that it doesn't allocate as long as populationSize doesn't exceed workspace.capacity()
+ * @param[in,out]  workspace   The scratch memory to use
+ */
+void exponentialRanking(int populationSize, float *fitness, bool maximizeFitness, float k1, int *winners, int winnersSize, SelectionWorkspace &workspace, RandomEngine &engine, SamplingMethod method = SamplingMethod::Automatic);
+
+/*!
+ * @brief Builds the distribution over ranks used by exponentialRanking, so that it can be sampled many times. Rank 0 is the best individual
+ * @param[in]   k1              Determines how much each rank weighs
+ * @param[in]   populationSize  The number of individuals
+ * @param[in]   method          The sampling method, must not be Automatic
+ * @param[out]  distribution    The distribution over the ranks
+ */
+void exponentialRankingDistribution(float k1, int populationSize, SamplingMethod method, SelectionDistribution &distribution);
+
+/*!
+ * @brief Returns the table built by exponentialRankingDistribution out of selectionTableCache(), building it only if it isn't cached
+ * @param[in]   k1              Determines how much each rank weighs
+ * @param[in]   populationSize  The number of individuals
+ * @param[in]   method          The sampling method, must not be Automatic
+ */
+SelectionTableCache::Table exponentialRankingTable(float k1, int populationSize, SamplingMethod method);
+
 /*!
  * @brief Picks winners by randomly selecting tournamentSize individuals winnersSize times, and then picking the individual with the highest fitness in each tournament
  * @param[in]   populationSize      The number of individuals
@@ -47,6 +145,69 @@ void exponentialRanking(int populationSize, float *fitness, bool maximizeFitness
  */
 void tournamentRanking(int populationSize, float *fitness, bool maximizeFitness, int tournamentSize, int *winners, int winnersSize);
 
+/*!
+ * @brief Same as above, but draws its random numbers from engine instead of the thread's default one
+ * @param[in,out]  engine  The random engine to draw from
+ */
+void tournamentRanking(int populationSize, float *fitness, bool maximizeFitness, int tournamentSize, int *winners, int winnersSize, RandomEngine &engine);
+
+/*!
+ * @brief Same as above, but takes its scratch memory from workspace, so that it doesn't allocate as long as populationSize doesn't exceed workspace.capacity()
+ * @param[in,out]  workspace   The scratch memory to use
+ */
+void tournamentRanking(int populationSize, float *fitness, bool maximizeFitness, int tournamentSize, int *winners, int winnersSize, SelectionWorkspace &workspace, RandomEngine &engine);
+
+/*!
+ * @brief Picks winners like tournamentRanking, but compares the contestants by a precomputed rank instead of by fitness. Each tournament only draws tournamentSize distinct contestants, so a round costs O(winnersSize*tournamentSize^2) regardless of populationSize
+ * @param[in]       populationSize  The number of individuals
+ * @param[in]       ranks           Array to the ranks of each individual, the lowest rank wins
+ * @param[in]       tournamentSize  Determines the size of each tournament
+ * @param[out]      winners         Array that will be filled with the indices of the picked winners
+ * @param[in]       winnersSize     The desired number of winners
+ * @param[in,out]   engine          The random engine to draw from
+ */
+void tournamentSelection(int populationSize, const int *ranks, int tournamentSize, int *winners, int winnersSize, RandomEngine &engine);
+
+/*!
+ * @brief Same as above, but takes its scratch memory from workspace, so that it doesn't allocate as long as populationSize doesn't exceed workspace.capacity()
+ * @param[in,out]  workspace   The scratch memory to use
+ */
+void tournamentSelection(int populationSize, const int *ranks, int tournamentSize, int *winners, int winnersSize, SelectionWorkspace &workspace, RandomEngine &engine);
+
+/*!
+ * @brief The selection schemes selectBatch can run
+ */
+enum class SelectionKind{
+    Roulette,       ///< rouletteRanking, the parameter is unused
+    Linear,         ///< linearRanking, the parameter is selectionPressure
+    Exponential,    ///< exponentialRanking, the parameter is k1
+    Tournament      ///< tournamentRanking, the parameter is tournamentSize
+};
+
+/*!
+ * @brief One of the selections selectBatch runs
+ */
+struct SelectionRequest{
+    SelectionKind kind;
+    float parameter;                                        ///< See SelectionKind
+    int *winners;                                           ///< Array that will be filled with the indices of the picked winners
+    int winnersSize;                                        ///< The desired number of winners
+    SamplingMethod method = SamplingMethod::Automatic;      ///< How the winners are drawn, ignored by Tournament
+};
+
+/*!
+ * @brief Runs several selections, with different schemes or parameters, over the same population. The population is ranked at most once for all of them, and the roulette wheel built at most once per sampling method, so strategies mixing several operators don't pay for a ranking each
+ * Each request gets the same winners the matching single selection function would give with the same engine state, except for Tournament, which compares ranks as tournamentSelection does
+ * @param[in]       populationSize  The number of individuals
+ * @param[in]       fitness         Array to the fitnesses of each individual
+ * @param[in]       maximizeFitness True if the objective is to maximize fitness, False otherwise
+ * @param[in]       requests        The selections to run, in order
+ * @param[in]       requestsSize    The length of requests
+ * @param[in,out]   workspace       The scratch memory to use
+ * @param[in,out]   engine          The random engine to draw from
+ */
+void selectBatch(int populationSize, float *fitness, bool maximizeFitness, const SelectionRequest *requests, int requestsSize, SelectionWorkspace &workspace, RandomEngine &engine);
+
 /*!
  * @brief Selects two random points among the ones defined in genesLoci and uses them to cut up and paste together three alternating sections from the two parents. Use this if not all of your genes are 1 byte long
  * @param[in]   parent1         The first parent
@@ -54,11 +215,17 @@ void tournamentRanking(int populationSize, float *fitness, bool maximizeFitness,
  * @param[in]   length          The length of the parents and, by consequence, the child
  * @param[out]  child           The result of cutting up and pasting the parents
  * @param[in]   genesLoci       The starting and ending positions of each gene
- * @note While the function has code to recognize whether you've included the extremes (0, length-1), it would need to allocate memory for them, so it's better if you generate genesLoci as having them yourself
+ * @note The extremes (0, length) can be left out of genesLoci, they're accounted for without copying it. If your genes have a fixed width and count known at compile time, the GenomeLayout operators in genome-layout.hpp avoid walking genesLoci altogether
  * @param[in]   genesLociLength The length of genesLoci
  */
 void twoPointsCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uint8_t *child, uint64_t *genesLoci, int genesLociLength);
 
+/*!
+ * @brief Same as above, but draws its random numbers from engine instead of the thread's default one
+ * @param[in,out]  engine  The random engine to draw from
+ */
+void twoPointsCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uint8_t *child, uint64_t *genesLoci, int genesLociLength, RandomEngine &engine);
+
 /*!
  * @brief Selects two random points and uses them to cut up and paste together three alternating sections from the two parents. Use this if every gene is 1 byte long.
  * @param[in]   parent1         The first parent
@@ -68,6 +235,12 @@ void twoPointsCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uin
  */
 void twoPointsCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uint8_t *child);
 
+/*!
+ * @brief Same as above, but draws its random numbers from engine instead of the thread's default one
+ * @param[in,out]  engine  The random engine to draw from
+ */
+void twoPointsCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uint8_t *child, RandomEngine &engine);
+
 /*!
  * @brief For each gene, as defined by genesLoci, selects whether child will inherit it from parent1 or parent2. Use this if not all of your genes are 1 byte long
  * @param[in]   parent1         The first parent
@@ -75,11 +248,17 @@ void twoPointsCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uin
  * @param[in]   length          The length of the parents and, by consequence, the child
  * @param[out]  child           The result of cutting up and pasting the parents
  * @param[in]   genesLoci       The starting and ending positions of each gene
- * @note While the function has code to recognize whether you've included the extremes (0, length-1), it would need to allocate memory for them, so it's better if you generate genesLoci as having them yourself
+ * @note The extremes (0, length) can be left out of genesLoci, they're accounted for without copying it. If your genes have a fixed width and count known at compile time, the GenomeLayout operators in genome-layout.hpp avoid walking genesLoci altogether
  * @param[in]   genesLociLength The length of genesLoci
  */
 void uniformCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uint8_t *child, uint64_t *genesLoci, int genesLociLength);
 
+/*!
+ * @brief Same as above, but draws its random numbers from engine instead of the thread's default one
+ * @param[in,out]  engine  The random engine to draw from
+ */
+void uniformCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uint8_t *child, uint64_t *genesLoci, int genesLociLength, RandomEngine &engine);
+
 
 /*!
  * @brief For each gene selects whether child will inherit it from parent1 or parent2. Use this if all of your genes are 1 byte long
@@ -90,10 +269,65 @@ void uniformCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uint8
  */
 void uniformCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uint8_t *child);
 
+/*!
+ * @brief Same as above, but draws its random numbers from engine instead of the thread's default one
+ * @param[in,out]  engine  The random engine to draw from
+ */
+void uniformCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uint8_t *child, RandomEngine &engine);
+
+/*!
+ * @brief For each byte selects whether child will inherit it from parent1, with probability parent1Probability, or from parent2. Random bits are drawn 64 at a time and expanded into byte masks, so this blends with SSE2 or AVX2 when the build enables them
+ * @param[in]       parent1             The first parent
+ * @param[in]       parent2             The second parent
+ * @param[in]       length              The length of the parents and, by consequence, the child
+ * @param[out]      child               The result of blending the parents
+ * @param[in]       parent1Probability  The probability each byte comes from parent1, with a resolution of 2^-16
+ * @param[in,out]   engine              The random engine to draw from
+ */
+void uniformCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uint8_t *child, float parent1Probability, RandomEngine &engine);
+
+/*!
+ * @brief For each bit selects whether child will inherit it from parent1, with probability parent1Probability, or from parent2. Use this if your genome is packed as one bit per gene
+ * @param[in]       parent1             The first parent
+ * @param[in]       parent2             The second parent
+ * @param[in]       words               The length of the parents and, by consequence, the child, in 64 bits words
+ * @param[out]      child               The result of blending the parents
+ * @param[in]       parent1Probability  The probability each bit comes from parent1, with a resolution of 2^-16
+ * @param[in,out]   engine              The random engine to draw from
+ */
+void packedUniformCrossover(const uint64_t *parent1, const uint64_t *parent2, uint64_t words, uint64_t *child, float parent1Probability, RandomEngine &engine);
+
 /*!
  * @brief Alters a random bit of each byte with mutationProbability probability. Use this if your genome has only 1 byte long genes, and all possible values for the genes are accepted. Otherwise you'll have to define your own function
+ * The distance to the next mutated byte is drawn from a geometric distribution, so the cost is proportional to the number of mutations rather than to length
  * @param[out]  individual          The genome to mutate
  * @param[in]   length              The length of individual
- * @param[in]   mutationProbability The probability each gene mutates
+ * @param[in]   mutationProbability The probability each gene mutates, in [0, 1]
  */
 void mutate(uint8_t *individual, int length, float mutationProbability);
+
+/*!
+ * @brief Same as above, but draws its random numbers from engine instead of the thread's default one
+ * @param[in,out]  engine  The random engine to draw from
+ */
+void mutate(uint8_t *individual, int length, float mutationProbability, RandomEngine &engine);
+
+/*!
+ * @brief Flips each bit with mutationProbability probability. Use this if your genome is packed as one bit per gene
+ * @param[out]      individual          The genome to mutate
+ * @param[in]       bits                The length of individual in bits
+ * @param[in]       mutationProbability The probability each bit flips, in [0, 1]
+ * @param[in,out]   engine              The random engine to draw from
+ */
+void packedMutate(uint64_t *individual, uint64_t bits, float mutationProbability, RandomEngine &engine);
+
+/*!
+ * @brief Alters a random bit of each gene, as defined by genesLoci, with mutationProbability probability. Use this if not all of your genes are 1 byte long
+ * @param[out]      individual          The genome to mutate
+ * @param[in]       length              The length of individual
+ * @param[in]       genesLoci           The starting and ending positions of each gene, with the same conventions as the crossover functions
+ * @param[in]       genesLociLength     The length of genesLoci
+ * @param[in]       mutationProbability The probability each gene mutates, in [0, 1]
+ * @param[in,out]   engine              The random engine to draw from
+ */
+void mutate(uint8_t *individual, uint64_t length, uint64_t *genesLoci, int genesLociLength, float mutationProbability, RandomEngine &engine);
@@ -0,0 +1,126 @@
+#pragma once
+///@file genome-layout.hpp
+///@brief Crossover and mutation specialised at compile time for genomes made of a fixed number of fixed width genes
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <random-engine.hpp>
+
+/*!
+ * @brief Describes a genome of N genes of type GeneT, laid out contiguously. The loci are known at compile time, so the operators below don't walk a genesLoci array and their copies have constant sizes the compiler can unroll and vectorise
+ * Use it as the template argument of the operators, e.g. uniformCrossover<GenomeLayout<float, 256>>(parent1, parent2, child, engine). The uint8_t* overloads in genetic-algorithm.hpp remain for layouts only known at run time
+ */
+template<typename GeneT, size_t N>
+struct GenomeLayout{
+    static_assert(std::is_trivially_copyable<GeneT>::value, "GenomeLayout: genes must be trivially copyable.");
+    static_assert(N>0, "GenomeLayout: a genome must have at least one gene.");
+
+    typedef GeneT Gene;
+    static constexpr size_t genes = N;                          ///< The number of genes
+    static constexpr uint64_t length = N*sizeof(GeneT);         ///< The length of the genome in bytes
+
+    /*!
+     * @brief The starting position, in bytes, of the i-th gene. locus(N) is length, so this is the constexpr equivalent of a genesLoci array that includes the extremes
+     */
+    static constexpr uint64_t locus(size_t i){ return i*sizeof(GeneT); }
+};
+
+//The unsigned integer a gene of the given width is blended as, void if there's none
+template<size_t Width> struct GeneWord{ typedef void type; };
+template<> struct GeneWord<1>{ typedef uint8_t type; };
+template<> struct GeneWord<2>{ typedef uint16_t type; };
+template<> struct GeneWord<4>{ typedef uint32_t type; };
+template<> struct GeneWord<8>{ typedef uint64_t type; };
+
+//Copies genes [begin, begin + count) from parent1 where the matching bit of bits is set, from parent2 elsewhere
+template<typename GeneT>
+inline void blendGenes(const GeneT *parent1, const GeneT *parent2, GeneT *child, size_t begin, size_t count, uint64_t bits, std::true_type){
+    //Branchless on the genes' bits, so that the loop vectorises
+    typedef typename GeneWord<sizeof(GeneT)>::type Word;
+    for(size_t j=0;j<count;++j){
+        Word a, b;
+        std::memcpy(&a, parent1 + begin + j, sizeof(Word));
+        std::memcpy(&b, parent2 + begin + j, sizeof(Word));
+        Word mask = Word(0) - Word((bits >> j) & 1);
+        Word c = Word((a & mask) | (b & ~mask));
+        std::memcpy(child + begin + j, &c, sizeof(Word));
+    }
+}
+
+template<typename GeneT>
+inline void blendGenes(const GeneT *parent1, const GeneT *parent2, GeneT *child, size_t begin, size_t count, uint64_t bits, std::false_type){
+    for(size_t j=0;j<count;++j){
+        std::memcpy(child + begin + j, ((bits >> j) & 1) ? parent1 + begin + j : parent2 + begin + j, sizeof(GeneT));
+    }
+}
+
+/*!
+ * @brief Selects two random loci and uses them to cut up and paste together three alternating sections from the two parents
+ * @tparam      Layout      The GenomeLayout of the parents and child
+ * @param[in]       parent1     The first parent
+ * @param[in]       parent2     The second parent
+ * @param[out]      child       The result of cutting up and pasting the parents
+ * @param[in,out]   engine      The random engine to draw from
+ */
+template<typename Layout>
+void twoPointsCrossover(const typename Layout::Gene *parent1, const typename Layout::Gene *parent2, typename Layout::Gene *child, RandomEngine &engine){
+    static_assert(Layout::genes>1, "twoPointsCrossover: can't crossover genomes with less than 2 genes.");
+    typedef typename Layout::Gene Gene;
+    //Any two distinct loci among the genes + 1, extremes included, like the genesLoci overload
+    const uint32_t lociCount = uint32_t(Layout::genes + 1);
+    uint32_t cut1 = engine.bounded(lociCount);
+    uint32_t cut2;
+    do{cut2 = engine.bounded(lociCount);} while(cut2==cut1);
+    if(cut1>cut2){
+        uint32_t dummy = cut2;
+        cut2 = cut1;
+        cut1 = dummy;
+    }
+    std::memcpy(child, parent1, cut1*sizeof(Gene));
+    std::memcpy(child + cut1, parent2 + cut1, (cut2 - cut1)*sizeof(Gene));
+    std::memcpy(child + cut2, parent1 + cut2, (Layout::genes - cut2)*sizeof(Gene));
+}
+
+/*!
+ * @brief For each gene selects whether child will inherit it from parent1 or parent2. One random number serves 64 genes, and genes of 1, 2, 4 or 8 bytes are blended without branches
+ * @tparam      Layout      The GenomeLayout of the parents and child
+ * @param[in]       parent1     The first parent
+ * @param[in]       parent2     The second parent
+ * @param[out]      child       The result of blending the parents
+ * @param[in,out]   engine      The random engine to draw from
+ */
+template<typename Layout>
+void uniformCrossover(const typename Layout::Gene *parent1, const typename Layout::Gene *parent2, typename Layout::Gene *child, RandomEngine &engine){
+    typedef typename Layout::Gene Gene;
+    typedef std::integral_constant<bool, !std::is_void<typename GeneWord<sizeof(Gene)>::type>::value> Blendable;
+    const size_t fullBlocks = Layout::genes/64;
+    const size_t tail = Layout::genes%64;
+    for(size_t block=0;block<fullBlocks;++block){
+        blendGenes(parent1, parent2, child, block*64, 64, engine(), Blendable());
+    }
+    if(tail){
+        blendGenes(parent1, parent2, child, fullBlocks*64, tail, engine(), Blendable());
+    }
+}
+
+/*!
+ * @brief Alters a random bit of each gene with mutationProbability probability. The distance to the next mutated gene is drawn from a geometric distribution, so the cost is proportional to the number of mutations
+ * @tparam      Layout              The GenomeLayout of individual
+ * @param[out]      individual          The genome to mutate
+ * @param[in]       mutationProbability The probability each gene mutates, in [0, 1]
+ * @param[in,out]   engine              The random engine to draw from
+ */
+template<typename Layout>
+void mutate(typename Layout::Gene *individual, float mutationProbability, RandomEngine &engine){
+    assert(mutationProbability>=0 && mutationProbability<=1 && "mutate: mutationProbability must be between 0 and 1.\n");
+    const uint64_t genes = Layout::genes;
+    const uint32_t geneBits = uint32_t(sizeof(typename Layout::Gene)*8);
+    unsigned char *bytes = reinterpret_cast<unsigned char*>(individual);
+    GeometricSkip skip(mutationProbability);
+    for(uint64_t g=skip.next(engine, genes);g<genes;g+=1 + skip.next(engine, genes)){
+        uint32_t bit = engine.bounded(geneBits);
+        bytes[Layout::locus(g) + (bit >> 3)] ^= 1 << (bit & 7);
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+///@file instrumentation.hpp
+///@brief Optional counters and timers of the library's operators, compiled into the library with its instrumentation option
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+/*!
+ * @brief The operators that are timed. Timings are inclusive: an operator that calls another one, e.g. linearRanking calling rankPopulation, also counts the time of the call
+ */
+enum class TelemetryOperator{
+    RouletteRanking,
+    LinearRanking,
+    ExponentialRanking,
+    TournamentRanking,
+    TournamentSelection,
+    SelectBatch,
+    RankPopulation,
+    NonDominatedSort,
+    CrowdingDistance,
+    CrowdedTournamentRanking,
+    TwoPointsCrossover,
+    UniformCrossover,
+    PackedUniformCrossover,
+    Mutate,
+    PackedMutate,
+    Reproduce,
+    EvaluateFitness,
+    WriteCheckpoint,
+    Count   ///< Not an operator, the number of operators
+};
+
+/*!
+ * @brief The events that are counted
+ */
+enum class TelemetryCounter{
+    Winners,            ///< Winners drawn by the selection functions
+    BytesCopied,        ///< Bytes of children written by the crossovers
+    Mutations,          ///< Bits flipped by the mutations
+    TableHits,          ///< Lookups of the ranking tables that found the table cached
+    TableMisses,        ///< Lookups of the ranking tables that had to build the table
+    FitnessHits,        ///< Genomes whose fitness was found in a FitnessCache
+    FitnessMisses,      ///< Genomes looked up in a FitnessCache that weren't in it
+    Allocations,        ///< Heap allocations made by the library's own buffers: workspaces, tables and populations
+    AllocatedBytes,     ///< The bytes of those allocations
+    Count               ///< Not a counter, the number of counters
+};
+
+const int telemetryOperatorCount = int(TelemetryOperator::Count);
+const int telemetryCounterCount = int(TelemetryCounter::Count);
+
+/*!
+ * @brief Whether the library was compiled with instrumentation. When it wasn't, the snapshots are all zeros and tracing writes an empty timeline
+ * @note It's decided when the library is built, with its instrumentation option: defining GENETIC_ALGORITHM_INSTRUMENTATION in the code that uses it changes nothing
+ */
+bool instrumentationEnabled();
+
+/*!
+ * @brief The calls of an operator and the time spent in them
+ */
+struct OperatorTelemetry{
+    uint64_t calls = 0;
+    uint64_t nanoseconds = 0;
+};
+
+/*!
+ * @brief The counters and timers of every thread, summed, over a generation or since the start
+ */
+struct TelemetrySnapshot{
+    uint64_t generation = 0;    ///< The generation, counted from 1, for generationTelemetry; 0 for telemetryTotals
+    OperatorTelemetry operators[telemetryOperatorCount];
+    uint64_t counters[telemetryCounterCount] = {};
+
+    const OperatorTelemetry& operation(TelemetryOperator op) const { return operators[int(op)]; }
+    uint64_t counter(TelemetryCounter counter) const { return counters[int(counter)]; }
+};
+
+/*!
+ * @brief The name of op, as used in the JSON and trace outputs
+ */
+const char* telemetryOperatorName(TelemetryOperator op);
+
+/*!
+ * @brief The name of counter, as used in the JSON output
+ */
+const char* telemetryCounterName(TelemetryCounter counter);
+
+/*!
+ * @brief Everything counted since the start of the process, or since the last resetTelemetry
+ */
+TelemetrySnapshot telemetryTotals();
+
+/*!
+ * @brief Ends a generation: returns what was counted since the previous call, or since the start for the first one, numbered with the next generation number. Call it once per generation, from one thread, while no operator runs
+ */
+TelemetrySnapshot generationTelemetry();
+
+/*!
+ * @brief Zeroes every counter and timer and restarts the generation numbers. Must not be called while an operator runs
+ */
+void resetTelemetry();
+
+/*!
+ * @brief Writes snapshot to file as a single line of JSON
+ */
+void writeTelemetryJson(std::FILE *file, const TelemetrySnapshot &snapshot);
+
+/*!
+ * @brief Starts recording every timed call as an event of a timeline, in memory. The timeline is written by stopTelemetryTrace
+ */
+void startTelemetryTrace();
+
+/*!
+ * @brief Stops recording and writes the timeline to path in the Chrome trace event format, which chrome://tracing and Perfetto open. Must not be called while an operator runs
+ * @throw std::system_error if path can't be written
+ */
+void stopTelemetryTrace(const std::string &path);
@@ -0,0 +1,146 @@
+#pragma once
+///@file island-model.hpp
+///@brief Several populations evolving independently and exchanging their best individuals
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <migration.hpp>
+#include <population.hpp>
+#include <random-engine.hpp>
+#include <selection-workspace.hpp>
+
+class ThreadPool;
+
+/*!
+ * @brief Which islands each island sends its migrants to
+ */
+enum class IslandTopology{
+    Ring,   ///< Island i sends to island i+1, the last one to the first
+    Torus,  ///< The islands form a grid as square as possible, wrapping around at the edges, and each sends to its four neighbours
+    Random  ///< At each migration, each island sends to another island drawn at random
+};
+
+/*!
+ * @brief Fills targets with the islands island sends its migrants to
+ * @param[in]       topology    The topology
+ * @param[in]       island      The sending island
+ * @param[in]       islands     The number of islands
+ * @param[in,out]   engine      The random engine to draw from, only used by the Random topology
+ * @param[out]      targets     The receiving islands, without duplicates nor island itself
+ */
+void migrationTargets(IslandTopology topology, int island, int islands, RandomEngine &engine, std::vector<int> &targets);
+
+/*!
+ * @brief Selects winnersSize winners out of populationSize individuals, e.g. by calling one of the selection functions
+ */
+typedef std::function<void(int populationSize, float *fitness, int *winners, int winnersSize, SelectionWorkspace &workspace, RandomEngine &engine)> IslandSelection;
+
+/*!
+ * @brief What every island of a model runs
+ */
+struct IslandSettings{
+    int populationSize = 0;
+    uint64_t genomeLength = 0;
+    bool maximizeFitness = true;
+    std::function<float(const uint8_t*, uint64_t)> evaluate;    ///< Computes the fitness of a genome, must be safe to call from several threads at once
+    IslandSelection select;                                     ///< Picks the parents of each generation
+    CrossoverKind crossoverKind = CrossoverKind::Uniform;
+    float mutationRate = 0.01f;                                 ///< See reproduce
+    IslandTopology topology = IslandTopology::Ring;
+    int migrationInterval = 10;                                 ///< The number of generations between two migrations
+    int migrationSize = 2;                                      ///< The number of migrants each island sends to each of its targets at each migration
+};
+
+/*!
+ * @brief Counters of an island's run, from which its throughput follows
+ */
+struct IslandStatistics{
+    uint64_t generations = 0;
+    uint64_t evaluations = 0;
+    uint64_t migrantsSent = 0;
+    uint64_t migrantsDropped = 0;       ///< Migrants the transport couldn't deliver
+    uint64_t migrantsReceived = 0;
+    double seconds = 0;                 ///< Wall time spent in run
+
+    double generationsPerSecond() const { return seconds>0 ? generations/seconds : 0; }
+    double evaluationsPerSecond() const { return seconds>0 ? evaluations/seconds : 0; }
+};
+
+/*!
+ * @brief One population of an island model, with all of its selection and reproduction state. Islands of the same process run on separate threads through IslandModel; islands in separate processes each construct their own and run it with a shared memory or socket transport
+ * Each generation evaluates the population, migrates if migrationInterval generations have passed, selects and reproduces. Emigrants are copies of the best individuals, immigrants replace the worst ones
+ */
+class Island{
+public:
+    /*!
+     * @brief Creates the island with a population of random genomes
+     * @param[in]   id          The index of the island among islands
+     * @param[in]   islands     The number of islands of the model
+     * @param[in]   settings    What the island runs
+     * @param[in]   seed        The seed of the model. Each island draws from its own stream of it, so a model's run only depends on seed
+     */
+    Island(int id, int islands, const IslandSettings &settings, uint64_t seed);
+
+    /*!
+     * @brief Runs generations generations, migrating through transport
+     */
+    void run(int generations, MigrationTransport &transport);
+
+    int id() const { return index; }
+    const Population& population() const { return genomes; }
+
+    /*!
+     * @brief The fitness of each individual of the current generation, as of the last evaluation or immigration
+     */
+    const std::vector<float>& fitness() const { return fitnesses; }
+
+    const IslandStatistics& statistics() const { return counters; }
+
+private:
+    void evaluate();
+    void migrate(MigrationTransport &transport);
+
+    int index;
+    int islands;
+    IslandSettings settings;
+    RandomEngine engine;
+    Population genomes;
+    std::vector<float> fitnesses;
+    std::vector<int> winners;
+    std::vector<int> targets;
+    std::vector<int> ranked;
+    std::vector<uint8_t> record;
+    SelectionWorkspace workspace;
+    IslandStatistics counters;
+    uint64_t generation = 0;
+    bool evaluated = false;     ///< Whether fitnesses matches the current generation
+};
+
+/*!
+ * @brief Islands of the same process, each running on its own thread and migrating through an InProcessTransport
+ */
+class IslandModel{
+public:
+    /*!
+     * @param[in]   islands     The number of islands
+     * @param[in]   settings    What every island runs
+     * @param[in]   seed        The seed the islands' streams are derived from
+     * @param[in]   linkSlots   The capacity in migrants of each link between two islands, must be a power of 2
+     */
+    IslandModel(int islands, const IslandSettings &settings, uint64_t seed, uint32_t linkSlots = 64);
+
+    /*!
+     * @brief Runs generations generations of every island, one island per chunk of pool. The islands never wait for each other, so the migrants an island receives depend on how the threads are scheduled
+     * @note The islands only evolve side by side if pool has at least as many threads as there are islands, otherwise some run after the others are done
+     */
+    void run(int generations, ThreadPool &pool);
+
+    int size() const { return int(islands.size()); }
+    Island& island(int i) { return *islands[i]; }
+    const Island& island(int i) const { return *islands[i]; }
+
+private:
+    std::vector<std::unique_ptr<Island>> islands;
+    InProcessTransport transport;
+};
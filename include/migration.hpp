@@ -0,0 +1,183 @@
+#pragma once
+///@file migration.hpp
+///@brief Lock-free queues and transports that carry migrants between islands, whether they're threads or processes
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*!
+ * @brief What precedes the genome in a migrant's record
+ */
+struct MigrantHeader{
+    float fitness;
+    int32_t source;     ///< The island the migrant comes from
+};
+
+/*!
+ * @brief The length in bytes of the record of a migrant whose genome is genomeLength bytes long
+ */
+inline uint64_t migrantRecordLength(uint64_t genomeLength){ return sizeof(MigrantHeader) + genomeLength; }
+
+/*!
+ * @brief Bounded single-producer single-consumer queue of fixed length records, over memory it doesn't own. It only uses lock-free atomics, so the memory can be shared between processes
+ */
+class MigrationQueue{
+public:
+    /*!
+     * @brief The number of bytes of memory a queue needs
+     * @param[in]   recordLength    The length in bytes of each record
+     * @param[in]   slots           The capacity of the queue in records, must be a power of 2
+     */
+    static uint64_t footprint(uint64_t recordLength, uint32_t slots);
+
+    /*!
+     * @param[in]   memory          footprint(recordLength, slots) bytes, aligned to a cache line
+     * @param[in]   recordLength    The length in bytes of each record
+     * @param[in]   slots           The capacity of the queue in records, must be a power of 2
+     * @param[in]   initialize      True to start an empty queue in memory, false to attach to one another process started
+     */
+    MigrationQueue(void *memory, uint64_t recordLength, uint32_t slots, bool initialize);
+
+    /*!
+     * @brief Appends record, unless the queue is full. Must only be called by the producer
+     * @return Whether record was appended
+     */
+    bool push(const uint8_t *record);
+
+    /*!
+     * @brief Takes the oldest record into record, unless the queue is empty. Must only be called by the consumer
+     * @return Whether a record was taken
+     */
+    bool pop(uint8_t *record);
+
+private:
+    //The cursors are on separate cache lines so that the producer and the consumer don't contend on them
+    struct alignas(64) Cursor{
+        std::atomic<uint64_t> value;
+    };
+    struct Control{
+        Cursor head;    ///< The next record to pop, written by the consumer
+        Cursor tail;    ///< The next record to push, written by the producer
+    };
+
+    Control *control;
+    uint8_t *records;
+    uint64_t recordLength;
+    uint64_t recordStride;
+    uint64_t mask;
+};
+
+/*!
+ * @brief How migrants travel from an island to another. Every island sends and receives through the transport from its own thread or process, and a transport never blocks: a migrant that can't be delivered right away is dropped
+ */
+class MigrationTransport{
+public:
+    virtual ~MigrationTransport(){}
+
+    /*!
+     * @brief Sends record from island from to island to
+     * @return False if the migrant was dropped
+     */
+    virtual bool send(int from, int to, const uint8_t *record) = 0;
+
+    /*!
+     * @brief Receives into record a migrant sent to island to by any island
+     * @return False if there was none waiting
+     */
+    virtual bool receive(int to, uint8_t *record) = 0;
+};
+
+/*!
+ * @brief Transport between islands running as threads of the same process, with one MigrationQueue per ordered pair of islands
+ */
+class InProcessTransport : public MigrationTransport{
+public:
+    /*!
+     * @param[in]   islands         The number of islands
+     * @param[in]   recordLength    The length of each migrant's record, see migrantRecordLength
+     * @param[in]   slots           The capacity in migrants of each link, must be a power of 2
+     */
+    InProcessTransport(int islands, uint64_t recordLength, uint32_t slots = 64);
+    ~InProcessTransport();
+    InProcessTransport(const InProcessTransport&) = delete;
+    InProcessTransport& operator=(const InProcessTransport&) = delete;
+
+    bool send(int from, int to, const uint8_t *record) override;
+    bool receive(int to, uint8_t *record) override;
+
+private:
+    int islands;
+    uint8_t *memory;
+    std::vector<MigrationQueue> links;  ///< links[from*islands + to]
+    std::vector<int> nextSource;        ///< The first link each island polls on its next receive, so that no source starves the others
+};
+
+/*!
+ * @brief Transport between islands running as separate processes on the same machine, with one MigrationQueue per ordered pair of islands in a POSIX shared memory object
+ */
+class SharedMemoryTransport : public MigrationTransport{
+public:
+    /*!
+     * @param[in]   name            The name of the shared memory object, as for shm_open, e.g. "/islands"
+     * @param[in]   islands         The number of islands
+     * @param[in]   recordLength    The length of each migrant's record, see migrantRecordLength
+     * @param[in]   slots           The capacity in migrants of each link, must be a power of 2
+     * @param[in]   create          True in exactly one process, which must construct its transport before the others: it creates and initializes the object
+     * @throw std::system_error if the object can't be created, opened or mapped
+     */
+    SharedMemoryTransport(const std::string &name, int islands, uint64_t recordLength, uint32_t slots, bool create);
+
+    /*!
+     * @brief Unmaps the object and, in the process that created it, unlinks its name
+     */
+    ~SharedMemoryTransport();
+    SharedMemoryTransport(const SharedMemoryTransport&) = delete;
+    SharedMemoryTransport& operator=(const SharedMemoryTransport&) = delete;
+
+    bool send(int from, int to, const uint8_t *record) override;
+    bool receive(int to, uint8_t *record) override;
+
+private:
+    std::string name;
+    bool owner;
+    int islands;
+    uint8_t *memory;
+    uint64_t length;
+    std::vector<MigrationQueue> links;  ///< links[from*islands + to]
+    std::vector<int> nextSource;
+};
+
+/*!
+ * @brief Transport between islands running as separate processes on the same machine, each bound to a Unix datagram socket named island-<i> in a directory. A migrant is one datagram, so records are limited by the system's maximum datagram size
+ */
+class SocketTransport : public MigrationTransport{
+public:
+    /*!
+     * @param[in]   directory       The directory the sockets are in
+     * @param[in]   islands         The number of islands
+     * @param[in]   recordLength    The length of each migrant's record, see migrantRecordLength
+     * @param[in]   localIslands    The islands this process runs, whose sockets it binds
+     * @throw std::system_error if a socket can't be created or bound
+     */
+    SocketTransport(const std::string &directory, int islands, uint64_t recordLength, const std::vector<int> &localIslands);
+
+    /*!
+     * @brief Closes and unlinks the sockets this process bound
+     */
+    ~SocketTransport();
+    SocketTransport(const SocketTransport&) = delete;
+    SocketTransport& operator=(const SocketTransport&) = delete;
+
+    bool send(int from, int to, const uint8_t *record) override;
+    bool receive(int to, uint8_t *record) override;
+
+private:
+    std::string socketPath(int island) const;
+    void bindSockets(const std::vector<int> &localIslands);
+    void closeSockets();
+
+    std::string directory;
+    uint64_t recordLength;
+    std::vector<int> sockets;   ///< The socket of each local island, -1 for the others
+};
@@ -0,0 +1,130 @@
+#pragma once
+///@file multi-objective.hpp
+///@brief NSGA-II style selection over several objectives: non-dominated sorting, crowding distance and crowded tournaments
+#include <cstdint>
+#include <vector>
+#include <random-engine.hpp>
+#include <selection-workspace.hpp>
+
+class ThreadPool;
+
+/*!
+ * @brief An individual and the key it's sorted by, used by the multi-objective kernels
+ */
+struct ParetoRecord{
+    uint64_t key;
+    int index;
+};
+
+/*!
+ * @brief Scratch memory for the multi-objective functions. As long as populationSize and objectivesCount don't exceed the ones it was reserved for, they don't allocate
+ * @note A workspace must not be shared by concurrent calls
+ */
+class ParetoWorkspace{
+public:
+    /*!
+     * @param[in]   maxPopulationSize   The biggest population that will be selected from. Can be 0, in which case the workspace grows on first use
+     * @param[in]   maxObjectivesCount  The most objectives the individuals will have
+     */
+    explicit ParetoWorkspace(int maxPopulationSize = 0, int maxObjectivesCount = 2);
+
+    /*!
+     * @brief Grows the workspace so that it can serve populations of up to populationSize individuals with up to objectivesCount objectives. Does nothing if it already can
+     */
+    void reserve(int populationSize, int objectivesCount);
+
+    int capacity() const { return maxPopulationSize; }
+    int objectivesCapacity() const { return maxObjectivesCount; }
+
+    std::vector<uint32_t> keys;             ///< The objectives of each individual as uint32s that sort in the same order, the best first
+    std::vector<uint32_t> distinctKeys;     ///< The distinct objective vectors, sorted lexicographically, with more than two objectives
+    std::vector<ParetoRecord> records;      ///< The individuals being sorted
+    std::vector<ParetoRecord> recordsSwap;  ///< The other buffer of the parallel merge sort
+    std::vector<uint64_t> frontTails;       ///< The key of the last individual added to each front, with two objectives
+    std::vector<int> distinctOf;            ///< The distinct vector of each sorted individual, with more than two objectives
+    std::vector<int> levels;                ///< The front of each distinct vector, with more than two objectives
+    std::vector<int> sweep;                 ///< Scratch space of the divide and conquer, with more than two objectives
+    std::vector<int> fronts;                ///< The front of each individual, as of the last crowdedRanking
+    std::vector<float> crowding;            ///< The crowding distance of each individual, as of the last crowdedRanking
+    std::vector<int> ranksLookup;           ///< The individual of each crowded rank, as of the last crowdedTournamentRanking
+    std::vector<int> ranks;                 ///< The crowded rank of each individual, as of the last crowdedTournamentRanking
+    SelectionWorkspace selection;           ///< The scratch memory of the tournaments
+
+private:
+    int maxPopulationSize = 0;
+    int maxObjectivesCount = 0;
+};
+
+/*!
+ * @brief Sorts the population into fronts of non-domination: front 0 holds the individuals no other one dominates, front 1 those only front 0 dominates, and so on. An individual dominates another one if it's at least as good in every objective and better in at least one
+ * The individuals are first sorted lexicographically by their objectives. With two objectives, each one is then placed, in that order, in the first front whose last member doesn't dominate it, found by binary search, so the whole sort costs O(N log N). With more, identical objective vectors are merged and the fronts follow from Jensen's divide and conquer over the objectives, in O(N log^(M-1) N)
+ * @param[in]       objectives      The objectives as a structure of arrays: objective m of individual i is objectives[m*populationSize + i]
+ * @param[in]       objectivesCount The number of objectives, M
+ * @param[in]       populationSize  The number of individuals, N
+ * @param[in]       maximizeFitness True if every objective is to be maximized, False if every one is to be minimized
+ * @param[out]      fronts          Array of populationSize elements that will be filled with the front of each individual
+ * @param[in,out]   workspace       The scratch memory to use
+ * @return The number of fronts
+ * @note Objectives must not be NaN. -0 and +0 are equal
+ */
+int nonDominatedSort(const float *objectives, int objectivesCount, int populationSize, bool maximizeFitness, int *fronts, ParetoWorkspace &workspace);
+
+/*!
+ * @brief Same as above, but computes the keys and sorts the individuals in parallel, one run per thread of pool merged pairwise. Placing them into fronts stays sequential
+ * @param[in,out]   pool    The threads to use
+ */
+int nonDominatedSort(const float *objectives, int objectivesCount, int populationSize, bool maximizeFitness, int *fronts, ParetoWorkspace &workspace, ThreadPool &pool);
+
+/*!
+ * @brief Computes the crowding distance of each individual within its front: the sum over the objectives of the distance between its two neighbours in the front, relative to the front's extent. The extremes of each objective, and the members of fronts of at most 2, are at an infinite distance
+ * @param[in]       objectives      The objectives as a structure of arrays, see nonDominatedSort
+ * @param[in]       objectivesCount The number of objectives
+ * @param[in]       populationSize  The number of individuals
+ * @param[in]       fronts          The front of each individual, as filled by nonDominatedSort
+ * @param[out]      distances       Array of populationSize elements that will be filled with the crowding distance of each individual
+ * @param[in,out]   workspace       The scratch memory to use
+ */
+void crowdingDistance(const float *objectives, int objectivesCount, int populationSize, const int *fronts, float *distances, ParetoWorkspace &workspace);
+
+/*!
+ * @brief Same as above, but sorts each objective in parallel
+ * @param[in,out]   pool    The threads to use
+ */
+void crowdingDistance(const float *objectives, int objectivesCount, int populationSize, const int *fronts, float *distances, ParetoWorkspace &workspace, ThreadPool &pool);
+
+/*!
+ * @brief Orders the population by NSGA-II's crowded comparison: lower fronts first and, within a front, larger crowding distances first. The first N individuals are the survivors of NSGA-II's environmental selection out of a merged parents and children population. Fills workspace.fronts and workspace.crowding along the way
+ * @param[in]       objectives      The objectives as a structure of arrays, see nonDominatedSort
+ * @param[in]       objectivesCount The number of objectives
+ * @param[in]       populationSize  The number of individuals
+ * @param[in]       maximizeFitness True if every objective is to be maximized, False if every one is to be minimized
+ * @param[out]      ranksLookup     Array of populationSize elements that will be filled with the index of the individual of each rank, the best one being at rank 0
+ * @param[in,out]   workspace       The scratch memory to use
+ */
+void crowdedRanking(const float *objectives, int objectivesCount, int populationSize, bool maximizeFitness, int *ranksLookup, ParetoWorkspace &workspace);
+
+/*!
+ * @brief Same as above, but sorts in parallel
+ * @param[in,out]   pool    The threads to use
+ */
+void crowdedRanking(const float *objectives, int objectivesCount, int populationSize, bool maximizeFitness, int *ranksLookup, ParetoWorkspace &workspace, ThreadPool &pool);
+
+/*!
+ * @brief NSGA-II's binary tournament, generalized to tournamentSize contestants: orders the population with crowdedRanking, then runs tournamentSelection over the crowded ranks, so that the contestant with the lowest front, and then the largest crowding distance, wins. Fills workspace.ranks and workspace.ranksLookup along the way
+ * @param[in]       populationSize  The number of individuals
+ * @param[in]       objectives      The objectives as a structure of arrays, see nonDominatedSort
+ * @param[in]       objectivesCount The number of objectives
+ * @param[in]       maximizeFitness True if every objective is to be maximized, False if every one is to be minimized
+ * @param[in]       tournamentSize  Determines the size of each tournament
+ * @param[out]      winners         Array that will be filled with the indices of the picked winners
+ * @param[in]       winnersSize     The desired number of winners
+ * @param[in,out]   workspace       The scratch memory to use
+ * @param[in,out]   engine          The random engine to draw from
+ */
+void crowdedTournamentRanking(int populationSize, const float *objectives, int objectivesCount, bool maximizeFitness, int tournamentSize, int *winners, int winnersSize, ParetoWorkspace &workspace, RandomEngine &engine);
+
+/*!
+ * @brief Same as above, but ranks in parallel. The tournaments themselves are drawn from engine alone, so the winners don't depend on the size of pool
+ * @param[in,out]   pool    The threads to use
+ */
+void crowdedTournamentRanking(int populationSize, const float *objectives, int objectivesCount, bool maximizeFitness, int tournamentSize, int *winners, int winnersSize, ParetoWorkspace &workspace, ThreadPool &pool, RandomEngine &engine);
@@ -0,0 +1,92 @@
+#pragma once
+///@file parallel-generation.hpp
+///@brief Versions of selection, reproduction and fitness evaluation that spread their work over a ThreadPool
+#include <cstdint>
+#include <functional>
+#include <genetic-algorithm.hpp>
+#include <population.hpp>
+#include <thread-pool.hpp>
+
+/*!
+ * @brief The number of winners each chunk of the parallel selection functions draws
+ */
+const int parallelSelectionGrain = 4096;
+
+/*!
+ * @brief The number of genome bytes each chunk of the parallel reproduce and evaluateFitness processes, rounded to whole genomes
+ */
+const uint64_t parallelGenomeGrain = 256*1024;
+
+/*!
+ * @brief Same as rouletteRanking, but draws the winners in parallel. The random numbers of each chunk of winners come from their own stream, seeded from a single draw from engine, so the winners only depend on engine and not on the size of pool
+ * @param[in,out]   pool    The threads to use
+ */
+void rouletteRanking(int populationSize, float *fitness, int *winners, int winnersSize, SelectionWorkspace &workspace, ThreadPool &pool, RandomEngine &engine, SamplingMethod method = SamplingMethod::Automatic);
+
+/*!
+ * @brief Same as linearRanking, but ranks the population and draws the winners in parallel, see rouletteRanking
+ * @param[in,out]   pool    The threads to use
+ */
+void linearRanking(int populationSize, float *fitness, bool maximizeFitness, float selectionPressure, int *winners, int winnersSize, SelectionWorkspace &workspace, ThreadPool &pool, RandomEngine &engine, SamplingMethod method = SamplingMethod::Automatic);
+
+/*!
+ * @brief Same as exponentialRanking, but ranks the population and draws the winners in parallel, see rouletteRanking
+ * @param[in,out]   pool    The threads to use
+ */
+void exponentialRanking(int populationSize, float *fitness, bool maximizeFitness, float k1, int *winners, int winnersSize, SelectionWorkspace &workspace, ThreadPool &pool, RandomEngine &engine, SamplingMethod method = SamplingMethod::Automatic);
+
+/*!
+ * @brief Same as tournamentRanking, but runs the tournaments in parallel, see rouletteRanking
+ * @param[in,out]   pool    The threads to use
+ */
+void tournamentRanking(int populationSize, float *fitness, bool maximizeFitness, int tournamentSize, int *winners, int winnersSize, ThreadPool &pool, RandomEngine &engine);
+
+/*!
+ * @brief Same as reproduce, but produces the children in parallel. Each chunk of children draws from its own stream, seeded from a single draw from engine, so the next generation only depends on engine and not on the size of pool. Chunks hold about parallelGenomeGrain bytes of children
+ * @param[in,out]   pool    The threads to use
+ */
+void reproduce(Population &population, const int *winners, CrossoverKind crossoverKind, float mutationRate, ThreadPool &pool, RandomEngine &engine);
+
+/*!
+ * @brief Same as above, but crossover and mutation respect the genes defined by genesLoci
+ * @param[in]   genesLoci       The starting and ending positions of each gene
+ * @param[in]   genesLociLength The length of genesLoci
+ */
+void reproduce(Population &population, const int *winners, CrossoverKind crossoverKind, float mutationRate, uint64_t *genesLoci, int genesLociLength, ThreadPool &pool, RandomEngine &engine);
+
+/*!
+ * @brief Computes the fitness of every individual of the current generation of population in parallel
+ * @param[in]       population  The individuals to evaluate
+ * @param[out]      fitness     Array of population.size() elements that will be filled with the fitness of each individual
+ * @param[in]       evaluate    Returns the fitness of a genome of the given length. It's called concurrently, so it must be thread-safe
+ * @param[in,out]   pool        The threads to use
+ */
+void evaluateFitness(const Population &population, float *fitness, const std::function<float(const uint8_t *genome, uint64_t length)> &evaluate, ThreadPool &pool);
+
+/*!
+ * @brief Same as reproduce with a FitnessMemo, but produces the children in parallel, see above
+ * @param[in,out]   pool    The threads to use
+ */
+int reproduce(Population &population, const int *winners, CrossoverKind crossoverKind, float mutationRate, uint64_t *genesLoci, int genesLociLength, FitnessMemo &memo, float *fitness,
+              ThreadPool &pool, RandomEngine &engine);
+
+/*!
+ * @brief Hashes every individual of the current generation of population and looks it up in memo's cache, as reproduce does for the children. Use it for the genomes reproduce didn't write, e.g. the first generation or immigrants
+ * @param[in]       population  The individuals to look up
+ * @param[in,out]   memo        The cache to look the individuals up in, and where their hashes and flags are written
+ * @param[out]      fitness     Array of population.size() elements, written for the individuals found in the cache
+ * @param[in,out]   pool        The threads to use
+ * @return The number of individuals whose fitness was found
+ */
+int lookupFitness(const Population &population, FitnessMemo &memo, float *fitness, ThreadPool &pool);
+
+/*!
+ * @brief Same as evaluateFitness, but only evaluates the individuals memo doesn't flag as known, and only once per distinct genome among them. Their fitnesses are added to memo's cache and they're flagged as known
+ * @param[in]       population  The individuals to evaluate, whose hashes and flags memo holds, from reproduce or lookupFitness
+ * @param[in,out]   fitness     Array of population.size() elements, whose unknown elements will be filled with the fitness of each individual
+ * @param[in]       evaluate    Returns the fitness of a genome of the given length. It's called concurrently, so it must be thread-safe
+ * @param[in,out]   memo        The hashes and flags of the individuals, and the cache to fill
+ * @param[in,out]   pool        The threads to use
+ * @return The number of times evaluate was called
+ */
+int evaluateFitness(const Population &population, float *fitness, const std::function<float(const uint8_t *genome, uint64_t length)> &evaluate, FitnessMemo &memo, ThreadPool &pool);
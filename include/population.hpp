@@ -0,0 +1,195 @@
+#pragma once
+///@file population.hpp
+///@brief Contiguous, double-buffered storage for a whole population and whole-generation reproduction on top of it
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <fitness-cache.hpp>
+#include <random-engine.hpp>
+
+/*!
+ * @brief The crossover reproduce applies to each pair of winners
+ */
+enum class CrossoverKind{
+    TwoPoints,  ///< twoPointsCrossover
+    Uniform     ///< uniformCrossover
+};
+
+/*!
+ * @brief The genomes of a generation pinned for a reader on another thread, e.g. a checkpoint being written, while the population moves on. They stay in the population's arena, which the population trades for its spare one at the next swap() if the reader isn't done, so they're never copied and the reader can take several generations
+ */
+class PinnedGenomes{
+public:
+    ~PinnedGenomes();
+    PinnedGenomes(const PinnedGenomes&) = delete;
+    PinnedGenomes& operator=(const PinnedGenomes&) = delete;
+
+    int size() const { return individuals; }
+    uint64_t genomeLength() const { return length; }
+
+    /*!
+     * @brief Calls visit(i, genome) for each i in [begin, end), in order. Keep the ranges short: the population's swap() waits for the range being read
+     * @param[in]   begin   The first genome to read, at least the end of the previous read: the genomes already read may be dropped
+     * @param[in]   end     The end of the range
+     * @param[in]   visit   Reads a genome
+     */
+    void read(int begin, int end, const std::function<void(int i, const uint8_t *genome)> &visit);
+
+    /*!
+     * @brief Tells the population the reader is done, so that it can overwrite the genomes, and pin again
+     */
+    void release();
+
+private:
+    friend class Population;
+    PinnedGenomes(const uint8_t *genomes, int size, uint64_t genomeLength, uint64_t stride);
+
+    //Copies the unread genomes out of the population's arena, for when the population is destroyed before the reader is done
+    void detach();
+
+    std::mutex mutex;
+    const uint8_t *genomes;     ///< Genome i is at genomes + (i - first)*step
+    uint8_t *copy = nullptr;
+    int first = 0;
+    uint64_t step;
+    int individuals;
+    uint64_t length;
+    int unread = 0;             ///< The genomes before it were read
+    bool released = false;
+    bool spared = false;        ///< Whether the population traded the genomes' arena for its spare one
+};
+
+/*!
+ * @brief Stores the genomes of the current and of the next generation in two contiguous arenas. Each genome starts on a cache line, and advancing a generation swaps the arenas instead of copying them
+ * A third, spare arena takes the place of a pinned one the reader isn't done with, see pin(). In memory it's only allocated by the first pin()
+ * The arenas are either in memory or in a memory-mapped file, for populations that don't fit in RAM. A file written with flush() can be reopened as is, which makes it a checkpoint of the genomes
+ */
+class Population{
+public:
+    /*!
+     * @param[in]   size            The number of individuals
+     * @param[in]   genomeLength    The length in bytes of each genome
+     */
+    Population(int size, uint64_t genomeLength);
+
+    /*!
+     * @brief Creates the population in the file at path, replacing it if it exists. The arenas start on huge page boundaries, and the kernel is asked to back them with huge pages where it can
+     * @param[in]   size            The number of individuals
+     * @param[in]   genomeLength    The length in bytes of each genome
+     * @param[in]   path            The file to keep the genomes in
+     * @throw std::system_error if the file can't be created or mapped
+     */
+    Population(int size, uint64_t genomeLength, const std::string &path);
+
+    /*!
+     * @brief Reopens a population written by the constructor above and saved with flush(), without copying its genomes
+     * @param[in]   path    The file the genomes are in
+     * @throw std::system_error if the file can't be opened or mapped, std::runtime_error if it isn't a population file
+     */
+    explicit Population(const std::string &path);
+
+    ~Population();
+    Population(const Population&) = delete;
+    Population& operator=(const Population&) = delete;
+
+    int size() const { return individuals; }
+    uint64_t genomeLength() const { return length; }
+
+    /*!
+     * @brief The distance in bytes between consecutive genomes, genomeLength() rounded up to a cache line
+     */
+    uint64_t stride() const { return genomeStride; }
+
+    /*!
+     * @brief The genome of the i-th individual of the current generation
+     */
+    uint8_t* genome(int i) { return buffers[current] + i*genomeStride; }
+    const uint8_t* genome(int i) const { return buffers[current] + i*genomeStride; }
+
+    /*!
+     * @brief The genome of the i-th individual of the next generation, to be written before calling swap()
+     */
+    uint8_t* nextGenome(int i) { return buffers[current ^ 1] + i*genomeStride; }
+
+    /*!
+     * @brief Makes the next generation the current one. If the previous current generation is pinned and its reader isn't done, its arena is traded for the spare one, so that the next generation is written there instead of over the pinned genomes
+     */
+    void swap(){
+        current ^= 1;
+        if(pinned){
+            unpin();
+        }
+    }
+
+    /*!
+     * @brief Pins the current generation for a reader on another thread, see PinnedGenomes. The genomes are never copied: they stay in their arena until the reader releases them, however many generations that takes
+     * @note The current genomes must not be modified until the next swap(), and they can only be pinned once at a time: the previous pin must have been released
+     */
+    std::shared_ptr<PinnedGenomes> pin();
+
+    /*!
+     * @brief Whether the genomes are kept in a memory-mapped file
+     */
+    bool mapped() const { return mapping!=nullptr; }
+
+    /*!
+     * @brief Records which arena is current and writes the genomes back to the file, so that reopening it resumes from this generation. Does nothing for in-memory populations
+     * @throw std::system_error if writing fails
+     */
+    void flush();
+
+    /*!
+     * @brief Asks the kernel to start reading the genome of the i-th individual of the current generation. Does nothing for in-memory populations
+     */
+    void prefetch(int i) const;
+
+    /*!
+     * @brief Tells the kernel the next generation is about to be written sequentially. Does nothing for in-memory populations
+     */
+    void adviseSequentialWrite();
+
+    std::vector<uint64_t> schedule;     ///< Scratch space for reproduce, the order in which the parent pairs are processed
+
+private:
+    int individuals;
+    uint64_t length;
+    uint64_t genomeStride;
+    uint8_t *buffers[2];
+    uint8_t *spare = nullptr;           ///< The arena the population trades a pinned one for, nullptr until needed in memory
+    int current = 0;
+    uint8_t *mapping = nullptr;
+    uint64_t mappingLength = 0;
+    int file = -1;
+    std::shared_ptr<PinnedGenomes> pinned;
+
+    void map(int descriptor, uint64_t fileLength);
+    void unpin();
+};
+
+/*!
+ * @brief Produces the whole next generation and makes it the current one. Child i is made by crossing over a pair of winners and then mutating the result. The pairs are processed in order of their parents' indices, so that consecutive children read nearby parents, and children are written sequentially
+ * @param[in,out]   population      The population to advance
+ * @param[in]       winners         Array of 2*population.size() indices, each consecutive two being the parents of a child
+ * @param[in]       crossoverKind   The crossover to apply to each pair
+ * @param[in]       mutationRate    The probability each byte mutates, see mutate. 0 disables mutation
+ * @param[in,out]   engine          The random engine to draw from
+ */
+void reproduce(Population &population, const int *winners, CrossoverKind crossoverKind, float mutationRate, RandomEngine &engine);
+
+/*!
+ * @brief Same as above, but crossover and mutation respect the genes defined by genesLoci. Use this if not all of your genes are 1 byte long
+ * @param[in]   genesLoci       The starting and ending positions of each gene
+ * @param[in]   genesLociLength The length of genesLoci
+ */
+void reproduce(Population &population, const int *winners, CrossoverKind crossoverKind, float mutationRate, uint64_t *genesLoci, int genesLociLength, RandomEngine &engine);
+
+/*!
+ * @brief Same as above, but also looks every child up in memo's cache, hashing it right after it's written. The children whose fitness is found are flagged in memo.known and get it in fitness, the others are left for evaluateFitness
+ * @param[in,out]   memo        The cache to look the children up in, and where their hashes and flags are written
+ * @param[out]      fitness     Array of population.size() elements, written for the children found in the cache. It can be the array the winners were selected from, as it isn't read
+ * @return The number of children whose fitness was found
+ */
+int reproduce(Population &population, const int *winners, CrossoverKind crossoverKind, float mutationRate, uint64_t *genesLoci, int genesLociLength, FitnessMemo &memo, float *fitness, RandomEngine &engine);
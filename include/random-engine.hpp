@@ -0,0 +1,128 @@
+#pragma once
+///@file random-engine.hpp
+///@brief Seedable random engine that the caller owns and passes to every operator
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+/*!
+ * @brief xoshiro256** generator. It satisfies UniformRandomBitGenerator, so it can also be handed to the std distributions.
+ * Construct it once, seed it explicitly if you need reproducible runs, and pass it by reference to the operators: it's cheap to copy but copies produce the same stream.
+ */
+struct RandomEngine{
+    typedef uint64_t result_type;
+
+    uint64_t state[4];
+
+    /*!
+     * @brief Seeds the engine from std::random_device
+     */
+    RandomEngine();
+
+    /*!
+     * @brief Seeds the engine deterministically
+     * @param[in]   seed    Expanded into the 256 bits of state through splitmix64
+     */
+    explicit RandomEngine(uint64_t seed);
+
+    /*!
+     * @brief Seeds the engine deterministically with the stream-th of the streams derived from seed. Different streams are seeded from independent hashes of (seed, stream), so they can be created in any order and on any thread
+     * @param[in]   seed    The seed shared by all the streams
+     * @param[in]   stream  The index of the stream
+     */
+    RandomEngine(uint64_t seed, uint64_t stream);
+
+    /*!
+     * @brief Reseeds the engine deterministically, as if it had just been constructed with seed
+     * @param[in]   seed    Expanded into the 256 bits of state through splitmix64
+     */
+    void seed(uint64_t seed);
+
+    /*!
+     * @brief Advances the engine by 2^128 steps, to obtain non-overlapping streams from a single seed
+     */
+    void jump();
+
+    static constexpr uint64_t min(){ return 0; }
+    static constexpr uint64_t max(){ return std::numeric_limits<uint64_t>::max(); }
+
+    uint64_t operator()(){
+        const uint64_t result = rotl(state[1]*5, 7)*9;
+        const uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+
+    /*!
+     * @brief Uniform integer in [0, range), using Lemire's multiply-and-shift. The bias is below 2^-32 for any range that fits in 32 bits
+     */
+    uint32_t bounded(uint32_t range){
+        return uint32_t(((operator()() >> 32)*uint64_t(range)) >> 32);
+    }
+
+    /*!
+     * @brief Uniform integer in [0, range) for ranges that may not fit in 32 bits, e.g. positions in a genome, using the full 128 bits product. The bias is below range/2^64
+     */
+    uint64_t bounded64(uint64_t range){
+        return multiplyHigh(operator()(), range);
+    }
+
+    /*!
+     * @brief Uniform float in [0, 1)
+     */
+    float uniformFloat(){
+        return float(operator()() >> 40)*(1.f/16777216.f);
+    }
+
+    /*!
+     * @brief Uniform double in [0, 1)
+     */
+    double uniformDouble(){
+        return double(operator()() >> 11)*(1./9007199254740992.);
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int k){
+        return (x << k) | (x >> (64 - k));
+    }
+
+    //The high 64 bits of a*b, from the products of their 32 bits halves
+    static uint64_t multiplyHigh(uint64_t a, uint64_t b){
+        uint64_t low = (a & 0xFFFFFFFF)*(b & 0xFFFFFFFF);
+        uint64_t middle1 = (a >> 32)*(b & 0xFFFFFFFF) + (low >> 32);
+        uint64_t middle2 = (a & 0xFFFFFFFF)*(b >> 32) + (middle1 & 0xFFFFFFFF);
+        return (a >> 32)*(b >> 32) + (middle1 >> 32) + (middle2 >> 32);
+    }
+};
+
+/*!
+ * @brief Draws how many Bernoulli trials of a given probability fail before the next success, so that an operator that touches each position with that probability costs one random number per touched position instead of one per position
+ */
+class GeometricSkip{
+public:
+    /*!
+     * @param[in]   probability The probability of success of each trial, in [0, 1]. 0 never succeeds and 1 always does
+     */
+    explicit GeometricSkip(float probability) : inverseLogComplement(probability>0 ? 1./std::log1p(-double(probability)) : -HUGE_VAL){}
+
+    /*!
+     * @brief Returns the number of failures before the next success, or limit if that's limit or more
+     */
+    uint64_t next(RandomEngine &engine, uint64_t limit) const{
+        double gap = std::log(1. - engine.uniformDouble())*inverseLogComplement;
+        return gap<double(limit) ? uint64_t(gap) : limit;
+    }
+
+private:
+    double inverseLogComplement;
+};
+
+/*!
+ * @brief Returns an engine private to the calling thread, seeded once from std::random_device. The overloads that don't take an engine use this one
+ */
+RandomEngine& defaultRandomEngine();
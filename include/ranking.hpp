@@ -0,0 +1,46 @@
+#pragma once
+///@file ranking.hpp
+///@brief Kernels that order a population by fitness
+#include <selection-workspace.hpp>
+
+class ThreadPool;
+
+/*!
+ * @brief Orders the population by fitness. Individuals with the same fitness keep the order of their indices, so every index appears exactly once. Populations of at least radixRankingThreshold individuals are sorted with an LSD radix sort, smaller ones with std::sort
+ * @param[in]       fitness         Array to the fitnesses of each individual
+ * @param[in]       populationSize  The number of individuals
+ * @param[in]       maximizeFitness True if the objective is to maximize fitness, False otherwise
+ * @param[out]      ranksLookup     Array of populationSize elements that will be filled with the index of the individual of each rank, the best one being at rank 0
+ * @param[in,out]   workspace       The scratch memory to use
+ */
+void rankPopulation(const float *fitness, int populationSize, bool maximizeFitness, int *ranksLookup, SelectionWorkspace &workspace);
+
+/*!
+ * @brief Same as above, but sorts one run per thread of pool in parallel and then merges the runs pairwise, also in parallel
+ * @param[in,out]   pool    The threads to use
+ */
+void rankPopulation(const float *fitness, int populationSize, bool maximizeFitness, int *ranksLookup, SelectionWorkspace &workspace, ThreadPool &pool);
+
+/*!
+ * @brief Like rankPopulation, but only the best count ranks are filled. Use this when only the elites or the top fraction are needed: it costs O(populationSize + count*log(count))
+ * @param[in]       fitness         Array to the fitnesses of each individual
+ * @param[in]       populationSize  The number of individuals
+ * @param[in]       maximizeFitness True if the objective is to maximize fitness, False otherwise
+ * @param[in]       count           The number of ranks to fill
+ * @param[out]      ranksLookup     Array of at least count elements that will be filled with the index of the individual of each of the best count ranks
+ * @param[in,out]   workspace       The scratch memory to use
+ */
+void partialRankPopulation(const float *fitness, int populationSize, bool maximizeFitness, int count, int *ranksLookup, SelectionWorkspace &workspace);
+
+/*!
+ * @brief The key rankPopulation sorts by: a uint64 whose high half orders fitness with the best individual first and whose low half is index, so that ties are broken by index
+ * @param[in]   fitness         The individual's fitness
+ * @param[in]   index           The individual's index
+ * @param[in]   maximizeFitness True if the objective is to maximize fitness, False otherwise
+ */
+uint64_t rankingKey(float fitness, int index, bool maximizeFitness);
+
+/*!
+ * @brief Below this populationSize, rankPopulation uses std::sort rather than a radix sort
+ */
+const int radixRankingThreshold = 1 << 12;
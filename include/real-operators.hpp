@@ -0,0 +1,121 @@
+#pragma once
+///@file real-operators.hpp
+///@brief Crossover and mutation for genomes of real-valued genes, instantiated for float and double
+#include <cstdint>
+#include <random-engine.hpp>
+
+/*!
+ * @brief Fills values with count uniform numbers in [0, 1). The random words are drawn first and then converted in a separate loop, which the compiler vectorises; a float takes 32 bits of a word, a double all 64
+ * @tparam  Real    float or double
+ */
+template<typename Real>
+void uniformReals(RandomEngine &engine, Real *values, uint64_t count);
+
+/*!
+ * @brief Fills values with count standard normal numbers, through the Box-Muller transform applied to blocks of uniformReals
+ * @tparam  Real    float or double
+ */
+template<typename Real>
+void normalReals(RandomEngine &engine, Real *values, uint64_t count);
+
+/*!
+ * @brief Makes child a weighted average of the parents, weight*parent1 + (1 - weight)*parent2, with one uniform weight per child
+ * @tparam          Real        float or double
+ * @param[in]       parent1     The first parent
+ * @param[in]       parent2     The second parent
+ * @param[in]       genes       The number of genes of the parents and, by consequence, the child
+ * @param[out]      child       The result of averaging the parents
+ * @param[in,out]   engine      The random engine to draw from
+ */
+template<typename Real>
+void arithmeticCrossover(const Real *parent1, const Real *parent2, uint64_t genes, Real *child, RandomEngine &engine);
+
+/*!
+ * @brief BLX-alpha: draws each gene of child uniformly from the parents' interval, widened by alpha times its width on each side, then clamps it to the bounds
+ * @tparam          Real            float or double
+ * @param[in]       parent1         The first parent
+ * @param[in]       parent2         The second parent
+ * @param[in]       genes           The number of genes of the parents and, by consequence, the child
+ * @param[out]      child           The result of blending the parents
+ * @param[in]       alpha           How much the interval is widened, 0.5 is the usual choice
+ * @param[in]       lowerBounds     The smallest value of each gene, or nullptr if unbounded from below
+ * @param[in]       upperBounds     The largest value of each gene, or nullptr if unbounded from above
+ * @param[in,out]   engine          The random engine to draw from
+ */
+template<typename Real>
+void blendCrossover(const Real *parent1, const Real *parent2, uint64_t genes, Real *child, float alpha, const Real *lowerBounds, const Real *upperBounds, RandomEngine &engine);
+
+/*!
+ * @brief Simulated binary crossover: each gene of child is one of the two offspring SBX would produce from the parents' genes, picked at random, then clamped to the bounds
+ * @tparam          Real                float or double
+ * @param[in]       parent1             The first parent
+ * @param[in]       parent2             The second parent
+ * @param[in]       genes               The number of genes of the parents and, by consequence, the child
+ * @param[out]      child               The result of crossing over the parents
+ * @param[in]       distributionIndex   The larger it is, the closer children stay to their parents. Usually between 2 and 20
+ * @param[in]       lowerBounds         The smallest value of each gene, or nullptr if unbounded from below
+ * @param[in]       upperBounds         The largest value of each gene, or nullptr if unbounded from above
+ * @param[in,out]   engine              The random engine to draw from
+ */
+template<typename Real>
+void simulatedBinaryCrossover(const Real *parent1, const Real *parent2, uint64_t genes, Real *child, float distributionIndex, const Real *lowerBounds, const Real *upperBounds, RandomEngine &engine);
+
+/*!
+ * @brief Adds normal noise of standard deviation sigma to each gene with mutationProbability probability, then clamps it to the bounds. The mutated genes are found through geometric skips and their noise is drawn in blocks
+ * @tparam          Real                float or double
+ * @param[in,out]   individual          The genome to mutate
+ * @param[in]       genes               The number of genes of individual
+ * @param[in]       mutationProbability The probability each gene mutates, in [0, 1]
+ * @param[in]       sigma               The standard deviation of the noise
+ * @param[in]       lowerBounds         The smallest value of each gene, or nullptr if unbounded from below
+ * @param[in]       upperBounds         The largest value of each gene, or nullptr if unbounded from above
+ * @param[in,out]   engine              The random engine to draw from
+ */
+template<typename Real>
+void gaussianMutate(Real *individual, uint64_t genes, float mutationProbability, float sigma, const Real *lowerBounds, const Real *upperBounds, RandomEngine &engine);
+
+/*!
+ * @brief Deb's polynomial mutation: perturbs each gene with mutationProbability probability, by an amount that shrinks as it approaches one of its bounds, so that it never leaves them
+ * @tparam          Real                float or double
+ * @param[in,out]   individual          The genome to mutate
+ * @param[in]       genes               The number of genes of individual
+ * @param[in]       mutationProbability The probability each gene mutates, in [0, 1]
+ * @param[in]       distributionIndex   The larger it is, the smaller the perturbations. Usually between 20 and 100
+ * @param[in]       lowerBounds         The smallest value of each gene
+ * @param[in]       upperBounds         The largest value of each gene
+ * @param[in,out]   engine              The random engine to draw from
+ */
+template<typename Real>
+void polynomialMutate(Real *individual, uint64_t genes, float mutationProbability, float distributionIndex, const Real *lowerBounds, const Real *upperBounds, RandomEngine &engine);
+
+/*!
+ * @brief Batched forms of the above. The genomes are rows of a matrix: row i starts at i*stride genes from the base pointer, which is how a Population of real genes is laid out, with stride = population.stride()/sizeof(Real)
+ * Offspring i is made from parents rows pairs[2*i] and pairs[2*i+1] and written to row i of offspring, as with the winners of reproduce
+ * @param[in]   parents         The first row of the parents' matrix
+ * @param[in]   pairs           Array of 2*offspringCount parents' rows
+ * @param[in]   offspringCount  The number of offspring
+ * @param[in]   genes           The number of genes of each row
+ * @param[in]   stride          The distance, in genes, between consecutive rows
+ * @param[out]  offspring       The first row of the offspring's matrix
+ */
+template<typename Real>
+void arithmeticCrossover(const Real *parents, const int *pairs, int offspringCount, uint64_t genes, uint64_t stride, Real *offspring, RandomEngine &engine);
+
+template<typename Real>
+void blendCrossover(const Real *parents, const int *pairs, int offspringCount, uint64_t genes, uint64_t stride, Real *offspring, float alpha, const Real *lowerBounds, const Real *upperBounds, RandomEngine &engine);
+
+template<typename Real>
+void simulatedBinaryCrossover(const Real *parents, const int *pairs, int offspringCount, uint64_t genes, uint64_t stride, Real *offspring, float distributionIndex, const Real *lowerBounds, const Real *upperBounds, RandomEngine &engine);
+
+/*!
+ * @brief Batched forms of the mutations, which mutate count rows of the matrix starting at individuals
+ * @param[in,out]   individuals     The first row of the matrix
+ * @param[in]       count           The number of rows
+ * @param[in]       genes           The number of genes of each row
+ * @param[in]       stride          The distance, in genes, between consecutive rows
+ */
+template<typename Real>
+void gaussianMutate(Real *individuals, int count, uint64_t genes, uint64_t stride, float mutationProbability, float sigma, const Real *lowerBounds, const Real *upperBounds, RandomEngine &engine);
+
+template<typename Real>
+void polynomialMutate(Real *individuals, int count, uint64_t genes, uint64_t stride, float mutationProbability, float distributionIndex, const Real *lowerBounds, const Real *upperBounds, RandomEngine &engine);
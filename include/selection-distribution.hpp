@@ -0,0 +1,90 @@
+#pragma once
+///@file selection-distribution.hpp
+///@brief Discrete distributions over a population, built once per generation and sampled many times
+#include <cstdint>
+#include <vector>
+#include <random-engine.hpp>
+
+/*!
+ * @brief How a SelectionDistribution draws an index
+ */
+enum class SamplingMethod{
+    BinarySearch,   ///< Binary search over the cumulative probabilities, O(log N) per draw and O(N) to build
+    Alias,          ///< Walker/Vose alias table, O(1) per draw with a single 64 bits random number, but a costlier O(N) build
+    Universal,      ///< Stochastic universal sampling: one random offset and evenly spaced pointers, resolved by a single merge over the cumulative probabilities, O(N + winners) per batch and with the least variance. Only batches are drawn this way, see sampleSelectionDistribution
+    Automatic       ///< Picks one of the above based on populationSize and winnersSize, see resolveSamplingMethod
+};
+
+/*!
+ * @brief A discrete distribution over [0, size). Build it with buildSelectionDistribution
+ */
+struct SelectionDistribution{
+    SamplingMethod method = SamplingMethod::BinarySearch;   ///< Never Automatic once the distribution is built
+    int size = 0;
+    std::vector<float> cumulativeProbabilities;             ///< Only filled by the BinarySearch and Universal methods
+    std::vector<float> thresholds;                          ///< Only filled by the Alias method, the probability of keeping the drawn column
+    std::vector<int> aliases;                               ///< Only filled by the Alias method, the index to return when the drawn column isn't kept
+    std::vector<int> worklist;                              ///< Scratch space for building the alias table, kept so that rebuilding doesn't allocate
+
+    /*!
+     * @brief Draws an index in [0, size). Distributions built with the Universal method draw single indices with a binary search
+     * @param[in,out]  engine  The random engine to draw from
+     */
+    int sample(RandomEngine &engine) const{
+        if(method==SamplingMethod::Alias){
+            uint64_t r = engine();
+            int column = int(((r >> 32)*uint64_t(size)) >> 32);
+            float u = float(uint32_t(r))*(1.f/4294967296.f);
+            return u<thresholds[column] ? column : aliases[column];
+        }
+        return sampleCumulative(engine.uniformDouble());
+    }
+
+private:
+    int sampleCumulative(double u) const;
+};
+
+/*!
+ * @brief Resolves SamplingMethod::Automatic into the method that's expected to be faster for drawing winnersSize indices out of populationSize: the alias table pays off once the log2(populationSize) cost of each binary search outweighs its build cost. Never resolves to Universal, as it changes the distribution of the batch as a whole
+ * @param[in]   method          The requested method. Returned as is unless it's Automatic
+ * @param[in]   populationSize  The size of the distribution
+ * @param[in]   winnersSize     The number of draws that will be made from it
+ */
+SamplingMethod resolveSamplingMethod(SamplingMethod method, int populationSize, int winnersSize);
+
+/*!
+ * @brief Builds a distribution out of a non-decreasing array of cumulative weights, which doesn't need to be normalized. The weight of index i is cumulativeWeights[i] - cumulativeWeights[i-1]
+ * @param[in]   cumulativeWeights   The cumulative weights
+ * @param[in]   size                The length of cumulativeWeights
+ * @param[in]   method              The sampling method, must not be Automatic
+ * @param[out]  distribution        The distribution to fill, its storage is reused if big enough
+ */
+void buildSelectionDistribution(const float *cumulativeWeights, int size, SamplingMethod method, SelectionDistribution &distribution);
+
+/*!
+ * @brief Draws winnersSize indices from distribution. With the Universal method every index i is drawn either floor or ceil of winnersSize*P(i) times, and the winners are shuffled afterwards so that consecutive ones are independent pairs
+ * @param[in]       distribution    The distribution to draw from
+ * @param[out]      winners         Array that will be filled with the drawn indices
+ * @param[in]       winnersSize     The desired number of winners
+ * @param[in,out]   engine          The random engine to draw from
+ */
+void sampleSelectionDistribution(const SelectionDistribution &distribution, int *winners, int winnersSize, RandomEngine &engine);
+
+/*!
+ * @brief Resolves count consecutive pointers of a stochastic universal sampling, without shuffling them: pointer k is at (offset + k)/winnersSize of the total weight. Splitting [0, winnersSize) into ranges and resolving them separately gives the same winners as resolving it at once
+ * @param[in]   distribution    The distribution to draw from, built with the BinarySearch or Universal method
+ * @param[in]   offset          The offset of the pointers, uniform in [0, 1)
+ * @param[in]   first           The first pointer to resolve
+ * @param[in]   count           The number of pointers to resolve
+ * @param[in]   winnersSize     The number of pointers of the whole sampling
+ * @param[out]  winners         Array of count elements that will be filled with the indices the pointers fall on, in non-decreasing order
+ */
+void sampleUniversal(const SelectionDistribution &distribution, double offset, int first, int count, int winnersSize, int *winners);
+
+/*!
+ * @brief Shuffles winners with the Fisher-Yates algorithm, so that the result only depends on engine
+ * @param[in,out]   winners         The array to shuffle
+ * @param[in]       winnersSize     The length of winners
+ * @param[in,out]   engine          The random engine to draw from
+ */
+void shuffleWinners(int *winners, int winnersSize, RandomEngine &engine);
@@ -0,0 +1,90 @@
+#pragma once
+///@file selection-table-cache.hpp
+///@brief Bounded, thread-safe cache of the precomputed rank-based selection tables
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <selection-distribution.hpp>
+
+/*!
+ * @brief The rank-based schemes whose tables only depend on a parameter and on populationSize
+ */
+enum class SelectionScheme{
+    Linear,         ///< linearRanking, the parameter is selectionPressure
+    Exponential     ///< exponentialRanking, the parameter is k1
+};
+
+/*!
+ * @brief Identifies a table in a SelectionTableCache
+ */
+struct SelectionTableKey{
+    SelectionScheme scheme;
+    SamplingMethod method;
+    float parameter;
+    int populationSize;
+
+    bool operator==(const SelectionTableKey &other) const{
+        return scheme==other.scheme && method==other.method && parameter==other.parameter && populationSize==other.populationSize;
+    }
+};
+
+/*!
+ * @brief Least recently used cache of selection tables. Lookups, insertions and evictions are O(1) under a short lock; the tables themselves are immutable and shared, so any number of threads can sample the same table at once, and a table stays alive for as long as someone holds it even after being evicted
+ */
+class SelectionTableCache{
+public:
+    typedef std::shared_ptr<const SelectionDistribution> Table;
+
+    /*!
+     * @param[in]   capacity    The maximum number of tables kept
+     */
+    explicit SelectionTableCache(int capacity = 8);
+
+    /*!
+     * @brief Returns the table for key, calling build to create it if it isn't cached. build runs outside of the lock, so a slow build doesn't hold up the other threads
+     * @param[in]   key     The table's identity
+     * @param[in]   build   Fills a SelectionDistribution with the table for key
+     */
+    Table fetch(const SelectionTableKey &key, const std::function<void(SelectionDistribution&)> &build);
+
+    /*!
+     * @brief Changes the maximum number of tables kept, evicting the least recently used ones if needed
+     * @param[in]   capacity    The maximum number of tables kept, must be positive
+     */
+    void setCapacity(int capacity);
+
+    int capacity() const;
+    int size() const;
+
+    /*!
+     * @brief Drops every table and resets the counters
+     */
+    void clear();
+
+    uint64_t hits() const { return hitCount.load(std::memory_order_relaxed); }
+    uint64_t misses() const { return missCount.load(std::memory_order_relaxed); }
+
+private:
+    struct KeyHash{
+        size_t operator()(const SelectionTableKey &key) const;
+    };
+    typedef std::list<std::pair<SelectionTableKey, Table>> Entries;
+
+    void evict();
+
+    mutable std::mutex mutex;
+    int maxSize;
+    Entries entries;        ///< Most recently used first
+    std::unordered_map<SelectionTableKey, Entries::iterator, KeyHash> index;
+    std::atomic<uint64_t> hitCount{0};
+    std::atomic<uint64_t> missCount{0};
+};
+
+/*!
+ * @brief The process-wide cache used by linearRanking and exponentialRanking
+ */
+SelectionTableCache& selectionTableCache();
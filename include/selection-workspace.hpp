@@ -0,0 +1,71 @@
+#pragma once
+///@file selection-workspace.hpp
+///@brief Scratch memory reused across selection calls, so that a generational loop doesn't touch the heap
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <selection-distribution.hpp>
+
+/*!
+ * @brief Scratch memory for the selection functions. Size it once for the biggest population you'll select from and pass it to every call: as long as populationSize doesn't exceed capacity(), selection won't allocate
+ * @note A workspace must not be shared by concurrent calls
+ */
+class SelectionWorkspace{
+public:
+    /*!
+     * @brief Creates a workspace that can serve populations of up to maxPopulationSize individuals without allocating
+     * @param[in]   maxPopulationSize   The biggest population that will be selected from. Can be 0, in which case the workspace grows on first use
+     */
+    explicit SelectionWorkspace(int maxPopulationSize = 0);
+
+    /*!
+     * @brief Grows the workspace so that it can serve populations of up to populationSize individuals. Does nothing if it already can
+     * @param[in]   populationSize  The number of individuals
+     */
+    void reserve(int populationSize);
+
+    /*!
+     * @brief The biggest population the workspace can serve without allocating
+     */
+    int capacity() const { return maxPopulationSize; }
+
+    /*!
+     * @brief The total number of bytes the workspace has allocated since it was created. Stays constant in steady state
+     */
+    uint64_t bytesAllocated() const { return allocatedBytes; }
+
+    /*!
+     * @brief Returns a scratch array of at least size elements out of buffer, growing it, and accounting for it, if needed
+     */
+    template<typename T>
+    T* scratch(std::vector<T> &buffer, size_t size){
+        if(buffer.capacity()<size){
+            uint64_t before = buffer.capacity()*sizeof(T);
+            buffer.reserve(size);
+            grew(buffer.capacity()*sizeof(T) - before);
+        }
+        if(buffer.size()<size){
+            buffer.resize(size);
+        }
+        return buffer.data();
+    }
+
+    std::vector<float> weights;             ///< Cumulative weights of the individuals
+    std::vector<uint64_t> sortKeys;         ///< The individuals' packed sorting keys, for ranking
+    std::vector<uint64_t> sortKeysSwap;     ///< The other buffer of the radix sort
+    std::vector<int> ranksLookup;           ///< The index of the individual of each rank
+    std::vector<int> ranks;                 ///< The rank of each individual, the inverse of ranksLookup
+    std::vector<int> contestants;           ///< The contestants of a batch of tournaments
+    SelectionDistribution distribution;     ///< The distribution winners are drawn from
+
+private:
+    void grew(uint64_t bytes);
+
+    int maxPopulationSize = 0;
+    uint64_t allocatedBytes = 0;
+};
+
+/*!
+ * @brief Returns a workspace private to the calling thread, which grows to fit the biggest population it has seen. The overloads that don't take a workspace use this one
+ */
+SelectionWorkspace& defaultSelectionWorkspace();
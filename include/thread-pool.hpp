@@ -0,0 +1,65 @@
+#pragma once
+///@file thread-pool.hpp
+///@brief Work-stealing thread pool for data parallel loops
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*!
+ * @brief A fixed set of threads that run parallelFor loops. Each participant starts on its own share of the chunks and, once that's exhausted, steals from the others, so uneven chunks don't leave threads idle
+ * @note parallelFor must not be called concurrently on the same pool, nor from inside a body
+ */
+class ThreadPool{
+public:
+    /*!
+     * @param[in]   threads The number of threads taking part in each loop, including the calling one. 0 uses std::thread::hardware_concurrency()
+     */
+    explicit ThreadPool(int threads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /*!
+     * @brief The number of threads taking part in each loop, including the calling one
+     */
+    int size() const { return int(queues.size()); }
+
+    /*!
+     * @brief Splits [0, count) into chunks of grain indices and calls body(chunk, begin, end) once for each, from any of the pool's threads. Returns once every chunk is done
+     * The chunks only depend on count and grain, never on the number of threads, so a body that derives its random numbers from the chunk index gives the same results whatever the size of the pool
+     * @param[in]   count   The number of indices
+     * @param[in]   grain   The number of indices per chunk, the last one may be shorter
+     * @param[in]   body    Processes the indices in [begin, end) of the chunk-th chunk
+     */
+    void parallelFor(int64_t count, int64_t grain, const std::function<void(int64_t chunk, int64_t begin, int64_t end)> &body);
+
+private:
+    struct Queue{
+        std::mutex mutex;
+        std::vector<int64_t> chunks;
+        size_t head = 0;    ///< Thieves take from here
+        size_t tail = 0;    ///< The owner takes from here
+    };
+
+    void workerLoop(int self);
+    void work(int self);
+    bool takeChunk(int self, int64_t &chunk);
+
+    std::vector<std::unique_ptr<Queue>> queues;     ///< One per participant, the last one belongs to the calling thread
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    uint64_t generation = 0;
+    int busy = 0;
+    bool stopping = false;
+    std::atomic<int64_t> remaining{0};
+    const std::function<void(int64_t, int64_t, int64_t)> *body = nullptr;
+    int64_t count = 0;
+    int64_t grain = 1;
+};
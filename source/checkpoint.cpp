@@ -0,0 +1,279 @@
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <system_error>
+#include <unistd.h>
+#include <checkpoint.hpp>
+#include "instrumentation-hooks.hpp"
+
+//The genomes are read from the pinned arena this many bytes at a time, rounded to whole genomes
+const uint64_t checkpointReadGrain = 1024*1024;
+
+struct CheckpointHeader{
+    char magic[8];
+    uint64_t version;
+    uint64_t generation;
+    uint64_t populationSize;
+    uint64_t genomeLength;
+    uint64_t enginesCount;
+    uint64_t fitnessCount;      ///< populationSize, or 0 if there are no fitnesses
+    uint64_t cacheCapacity;     ///< 0 if there's no cache
+    uint64_t cacheEntries;
+};
+const char checkpointMagic[8] = {'G', 'A', 'C', 'H', 'E', 'C', 'K', '\0'};
+const uint64_t checkpointVersion = 1;
+
+//The bytes of a cache entry in the file: its slot, its hash and its fitness, without padding
+const uint64_t cacheEntryBytes = 2*sizeof(uint64_t) + sizeof(float);
+
+struct CheckpointImage{
+    uint64_t generation = 0;
+    std::vector<RandomEngine> engines;
+    std::vector<float> fitness;
+    std::shared_ptr<PinnedGenomes> genomes;
+    uint64_t cacheCapacity = 0;
+    std::vector<FitnessCacheEntry> cacheEntries;
+};
+
+//Copies everything but the genomes, which are pinned
+void captureImage(const GenerationState &state, CheckpointImage &image){
+    assert(state.population && "saveCheckpoint: the state has no population.\n");
+    image.generation = state.generation;
+    image.engines.clear();
+    for(const RandomEngine *engine : state.engines){
+        assert(engine);
+        image.engines.push_back(*engine);
+    }
+    image.fitness.clear();
+    if(state.fitness){
+        image.fitness.assign(state.fitness, state.fitness + state.population->size());
+    }
+    image.cacheEntries.clear();
+    image.cacheCapacity = state.cache ? state.cache->capacity() : 0;
+    if(state.cache){
+        state.cache->save(image.cacheEntries);
+    }
+    image.genomes = state.population->pin();
+}
+
+//Each block is hashed on its own and folded into the checksum, so that the reader checks the same blocks it reads
+inline void foldChecksum(uint64_t &checksum, const void *data, uint64_t length){
+    checksum = (checksum ^ genomeHash(static_cast<const uint8_t*>(data), length))*0x9E3779B185EBCA87;
+}
+
+void writeBlock(std::FILE *file, const void *data, uint64_t length, uint64_t &checksum){
+    if(std::fwrite(data, 1, length, file)!=length){
+        throw std::system_error(errno, std::generic_category(), "saveCheckpoint: couldn't write the checkpoint");
+    }
+    foldChecksum(checksum, data, length);
+}
+
+void writeImageTo(std::FILE *file, const CheckpointImage &image){
+    PinnedGenomes &genomes = *image.genomes;
+    CheckpointHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, checkpointMagic, sizeof(header.magic));
+    header.version = checkpointVersion;
+    header.generation = image.generation;
+    header.populationSize = uint64_t(genomes.size());
+    header.genomeLength = genomes.genomeLength();
+    header.enginesCount = image.engines.size();
+    header.fitnessCount = image.fitness.size();
+    header.cacheCapacity = image.cacheCapacity;
+    header.cacheEntries = image.cacheEntries.size();
+    uint64_t checksum = 0;
+    writeBlock(file, &header, sizeof(header), checksum);
+    for(const RandomEngine &engine : image.engines){
+        writeBlock(file, engine.state, sizeof(engine.state), checksum);
+    }
+    if(!image.fitness.empty()){
+        writeBlock(file, image.fitness.data(), image.fitness.size()*sizeof(float), checksum);
+    }
+    int batch = int(std::max<uint64_t>(1, checkpointReadGrain/genomes.genomeLength()));
+    for(int begin=0;begin<genomes.size();begin+=batch){
+        genomes.read(begin, std::min(begin + batch, genomes.size()), [&](int, const uint8_t *genome){
+            writeBlock(file, genome, genomes.genomeLength(), checksum);
+        });
+    }
+    for(const FitnessCacheEntry &entry : image.cacheEntries){
+        uint8_t bytes[cacheEntryBytes];
+        std::memcpy(bytes, &entry.slot, sizeof(entry.slot));
+        std::memcpy(bytes + sizeof(entry.slot), &entry.hash, sizeof(entry.hash));
+        std::memcpy(bytes + 2*sizeof(uint64_t), &entry.fitness, sizeof(entry.fitness));
+        writeBlock(file, bytes, cacheEntryBytes, checksum);
+    }
+    if(std::fwrite(&checksum, sizeof(checksum), 1, file)!=1){
+        throw std::system_error(errno, std::generic_category(), "saveCheckpoint: couldn't write the checkpoint");
+    }
+}
+
+void writeImage(const std::string &path, const CheckpointImage &image){
+    INSTRUMENT_OPERATOR(WriteCheckpoint);
+    std::string temporary = path + ".tmp";
+    std::FILE *file = std::fopen(temporary.c_str(), "wb");
+    if(!file){
+        throw std::system_error(errno, std::generic_category(), "saveCheckpoint: couldn't create " + temporary);
+    }
+    try{
+        writeImageTo(file, image);
+        if(std::fflush(file) || fsync(fileno(file))){
+            throw std::system_error(errno, std::generic_category(), "saveCheckpoint: couldn't write " + temporary);
+        }
+    } catch(...){
+        std::fclose(file);
+        std::remove(temporary.c_str());
+        throw;
+    }
+    if(std::fclose(file) || std::rename(temporary.c_str(), path.c_str())){
+        int error = errno;
+        std::remove(temporary.c_str());
+        throw std::system_error(error, std::generic_category(), "saveCheckpoint: couldn't write " + path);
+    }
+}
+
+void saveCheckpoint(const std::string &path, const GenerationState &state){
+    CheckpointImage image;
+    captureImage(state, image);
+    try{
+        writeImage(path, image);
+    } catch(...){
+        image.genomes->release();
+        throw;
+    }
+    image.genomes->release();
+}
+
+void readBlock(std::FILE *file, void *data, uint64_t length, uint64_t &checksum, const std::string &path){
+    if(std::fread(data, 1, length, file)!=length){
+        if(std::ferror(file)){
+            throw std::system_error(errno, std::generic_category(), "loadCheckpoint: couldn't read " + path);
+        }
+        throw std::runtime_error("loadCheckpoint: " + path + " is truncated.");
+    }
+    foldChecksum(checksum, data, length);
+}
+
+void loadCheckpoint(const std::string &path, GenerationState &state){
+    assert(state.population && "loadCheckpoint: the state has no population.\n");
+    std::unique_ptr<std::FILE, int(*)(std::FILE*)> file(std::fopen(path.c_str(), "rb"), std::fclose);
+    if(!file){
+        throw std::system_error(errno, std::generic_category(), "loadCheckpoint: couldn't open " + path);
+    }
+    Population &population = *state.population;
+    uint64_t checksum = 0;
+    CheckpointHeader header;
+    readBlock(file.get(), &header, sizeof(header), checksum, path);
+    if(std::memcmp(header.magic, checkpointMagic, sizeof(header.magic)) || header.version!=checkpointVersion){
+        throw std::runtime_error("loadCheckpoint: " + path + " isn't a checkpoint.");
+    }
+    if(header.populationSize!=uint64_t(population.size()) || header.genomeLength!=population.genomeLength() || header.enginesCount!=state.engines.size() ||
+       header.fitnessCount!=(state.fitness ? header.populationSize : 0) || header.cacheCapacity!=(state.cache ? state.cache->capacity() : 0) ||
+       header.cacheEntries>header.cacheCapacity){
+        throw std::runtime_error("loadCheckpoint: " + path + " doesn't match the state it's restored into.");
+    }
+    //Everything but the genomes is only restored once the checksum matches
+    std::vector<RandomEngine> engines(header.enginesCount);
+    for(RandomEngine &engine : engines){
+        readBlock(file.get(), engine.state, sizeof(engine.state), checksum, path);
+    }
+    std::vector<float> fitness(header.fitnessCount);
+    if(!fitness.empty()){
+        readBlock(file.get(), fitness.data(), fitness.size()*sizeof(float), checksum, path);
+    }
+    for(int i=0;i<population.size();++i){
+        readBlock(file.get(), population.genome(i), population.genomeLength(), checksum, path);
+    }
+    std::vector<FitnessCacheEntry> entries(header.cacheEntries);
+    for(FitnessCacheEntry &entry : entries){
+        uint8_t bytes[cacheEntryBytes];
+        readBlock(file.get(), bytes, cacheEntryBytes, checksum, path);
+        std::memcpy(&entry.slot, bytes, sizeof(entry.slot));
+        std::memcpy(&entry.hash, bytes + sizeof(entry.slot), sizeof(entry.hash));
+        std::memcpy(&entry.fitness, bytes + 2*sizeof(uint64_t), sizeof(entry.fitness));
+        if(entry.slot>=header.cacheCapacity){
+            throw std::runtime_error("loadCheckpoint: " + path + " is corrupted.");
+        }
+    }
+    uint64_t expected;
+    if(std::fread(&expected, sizeof(expected), 1, file.get())!=1 || expected!=checksum || std::fgetc(file.get())!=EOF){
+        throw std::runtime_error("loadCheckpoint: " + path + " is corrupted.");
+    }
+    state.generation = header.generation;
+    for(size_t e=0;e<engines.size();++e){
+        *state.engines[e] = engines[e];
+    }
+    if(state.fitness){
+        std::copy(fitness.begin(), fitness.end(), state.fitness);
+    }
+    if(state.cache){
+        state.cache->restore(entries.data(), entries.size());
+    }
+}
+
+CheckpointWriter::CheckpointWriter() : image(new CheckpointImage){
+    //Started last, once the members it uses exist
+    writer = std::thread(&CheckpointWriter::writerLoop, this);
+}
+
+CheckpointWriter::~CheckpointWriter(){
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&]{ return !pending; });
+        stopping = true;
+    }
+    wake.notify_all();
+    writer.join();
+}
+
+void CheckpointWriter::write(const std::string &path, const GenerationState &state){
+    wait();
+    //The writer thread is idle, so the image is ours until pending is set
+    captureImage(state, *image);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->path = path;
+        pending = true;
+    }
+    wake.notify_all();
+}
+
+void CheckpointWriter::wait(){
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&]{ return !pending; });
+    if(error){
+        std::exception_ptr failure = error;
+        error = nullptr;
+        std::rethrow_exception(failure);
+    }
+}
+
+bool CheckpointWriter::busy() const{
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending;
+}
+
+void CheckpointWriter::writerLoop(){
+    std::unique_lock<std::mutex> lock(mutex);
+    while(true){
+        wake.wait(lock, [&]{ return stopping || pending; });
+        if(stopping){
+            return;
+        }
+        lock.unlock();
+        std::exception_ptr failure;
+        try{
+            writeImage(path, *image);
+        } catch(...){
+            failure = std::current_exception();
+        }
+        image->genomes->release();
+        image->genomes.reset();
+        lock.lock();
+        error = failure;
+        pending = false;
+        done.notify_all();
+    }
+}
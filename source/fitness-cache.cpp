@@ -0,0 +1,244 @@
+#include <cassert>
+#include <cstring>
+#include <fitness-cache.hpp>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+const uint64_t hashStripe = 64;
+const uint64_t hashStripesPerBlock = 16;
+const uint64_t hashPrime32 = 0x9E3779B1;
+const uint64_t hashPrime64 = 0x9E3779B185EBCA87;
+
+//Stripe s of a block mixes its 8 lanes with keys s to s+7, then come the 8 scrambling keys and the 8 merging keys
+const int stripeKeys = int(hashStripesPerBlock) + 7;
+const int scrambleKeys = stripeKeys;
+const int mergeKeys = scrambleKeys + 8;
+
+struct HashSecret{
+    uint64_t keys[mergeKeys + 8];
+
+    //splitmix64 out of an arbitrary seed
+    constexpr HashSecret() : keys(){
+        uint64_t state = 0x243F6A8885A308D3;
+        for(uint64_t &key : keys){
+            uint64_t z = (state += 0x9e3779b97f4a7c15);
+            z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9;
+            z = (z ^ (z >> 27))*0x94d049bb133111eb;
+            key = z ^ (z >> 31);
+        }
+    }
+};
+constexpr HashSecret hashSecret;
+
+inline uint64_t readWord(const uint8_t *p){
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+//The high and low halves of the 128 bits product, folded together
+inline uint64_t foldedProduct(uint64_t a, uint64_t b){
+    __uint128_t product = __uint128_t(a)*b;
+    return uint64_t(product) ^ uint64_t(product >> 64);
+}
+
+inline uint64_t avalanche(uint64_t h){
+    h ^= h >> 37;
+    h *= 0x165667919E3779F9;
+    return h ^ (h >> 32);
+}
+
+//Each lane adds the product of the low and high halves of its keyed word, and the unkeyed word of its neighbour
+inline void accumulateStripeScalar(uint64_t *accumulators, const uint8_t *stripe, const uint64_t *keys){
+    for(int lane=0;lane<8;++lane){
+        uint64_t word = readWord(stripe + 8*lane);
+        uint64_t keyed = word ^ keys[lane];
+        accumulators[lane ^ 1] += word;
+        accumulators[lane] += (keyed & 0xffffffff)*(keyed >> 32);
+    }
+}
+
+//Same as accumulateStripeScalar over count consecutive stripes, stripe k using the keys k onwards
+inline void accumulateStripes(uint64_t *accumulators, const uint8_t *stripes, uint64_t count){
+#if defined(__AVX2__)
+    __m256i lanes[2] = {_mm256_loadu_si256((const __m256i*)accumulators), _mm256_loadu_si256((const __m256i*)(accumulators + 4))};
+    for(uint64_t s=0;s<count;++s){
+        for(int half=0;half<2;++half){
+            __m256i word = _mm256_loadu_si256((const __m256i*)(stripes + s*hashStripe + 32*half));
+            __m256i keyed = _mm256_xor_si256(word, _mm256_loadu_si256((const __m256i*)(hashSecret.keys + s + 4*half)));
+            __m256i product = _mm256_mul_epu32(keyed, _mm256_srli_epi64(keyed, 32));
+            __m256i neighbour = _mm256_shuffle_epi32(word, _MM_SHUFFLE(1, 0, 3, 2));
+            lanes[half] = _mm256_add_epi64(lanes[half], _mm256_add_epi64(product, neighbour));
+        }
+    }
+    _mm256_storeu_si256((__m256i*)accumulators, lanes[0]);
+    _mm256_storeu_si256((__m256i*)(accumulators + 4), lanes[1]);
+#elif defined(__SSE2__)
+    __m128i lanes[4];
+    for(int quarter=0;quarter<4;++quarter){
+        lanes[quarter] = _mm_loadu_si128((const __m128i*)(accumulators + 2*quarter));
+    }
+    for(uint64_t s=0;s<count;++s){
+        for(int quarter=0;quarter<4;++quarter){
+            __m128i word = _mm_loadu_si128((const __m128i*)(stripes + s*hashStripe + 16*quarter));
+            __m128i keyed = _mm_xor_si128(word, _mm_loadu_si128((const __m128i*)(hashSecret.keys + s + 2*quarter)));
+            __m128i product = _mm_mul_epu32(keyed, _mm_srli_epi64(keyed, 32));
+            __m128i neighbour = _mm_shuffle_epi32(word, _MM_SHUFFLE(1, 0, 3, 2));
+            lanes[quarter] = _mm_add_epi64(lanes[quarter], _mm_add_epi64(product, neighbour));
+        }
+    }
+    for(int quarter=0;quarter<4;++quarter){
+        _mm_storeu_si128((__m128i*)(accumulators + 2*quarter), lanes[quarter]);
+    }
+#else
+    for(uint64_t s=0;s<count;++s){
+        accumulateStripeScalar(accumulators, stripes + s*hashStripe, hashSecret.keys + s);
+    }
+#endif
+}
+
+//Keeps the products of a block from cancelling out with those of the next ones
+inline void scramble(uint64_t *accumulators){
+    for(int lane=0;lane<8;++lane){
+        uint64_t a = accumulators[lane];
+        accumulators[lane] = (a ^ (a >> 47) ^ hashSecret.keys[scrambleKeys + lane])*hashPrime32;
+    }
+}
+
+uint64_t shortGenomeHash(const uint8_t *genome, uint64_t length){
+    uint64_t h = length*hashPrime64;
+    uint64_t i = 0;
+    for(;i+16<=length;i+=16){
+        h += foldedProduct(readWord(genome + i) ^ hashSecret.keys[i/8], readWord(genome + i + 8) ^ hashSecret.keys[i/8 + 1]);
+    }
+    if(i<length){
+        //Zero padded, the length tells the padding apart from actual zeros
+        uint64_t words[2] = {0, 0};
+        std::memcpy(words, genome + i, length - i);
+        h += foldedProduct(words[0] ^ hashSecret.keys[8], words[1] ^ hashSecret.keys[9]);
+    }
+    return avalanche(h);
+}
+
+uint64_t genomeHash(const uint8_t *genome, uint64_t length){
+    assert(genome || !length);
+    if(length<=hashStripe){
+        return shortGenomeHash(genome, length);
+    }
+    uint64_t accumulators[8] = {hashPrime32, hashPrime64, hashPrime64 ^ length, hashPrime32 ^ length,
+                                ~hashPrime64, ~hashPrime32, length, hashPrime64*length};
+    uint64_t blockLength = hashStripe*hashStripesPerBlock;
+    //The last stripe is always hashed on its own, so that partial stripes don't need padding
+    uint64_t stripes = (length - 1)/hashStripe;
+    uint64_t blocks = stripes/hashStripesPerBlock;
+    for(uint64_t b=0;b<blocks;++b){
+        accumulateStripes(accumulators, genome + b*blockLength, hashStripesPerBlock);
+        scramble(accumulators);
+    }
+    accumulateStripes(accumulators, genome + blocks*blockLength, stripes - blocks*hashStripesPerBlock);
+    accumulateStripeScalar(accumulators, genome + length - hashStripe, hashSecret.keys + 7);
+    uint64_t h = length*hashPrime64;
+    for(int lane=0;lane<8;lane+=2){
+        h += foldedProduct(accumulators[lane] ^ hashSecret.keys[mergeKeys + lane], accumulators[lane + 1] ^ hashSecret.keys[mergeKeys + lane + 1]);
+    }
+    return avalanche(h);
+}
+
+FitnessCache::FitnessCache(uint64_t capacity){
+    uint64_t bucketCount = 1;
+    while(bucketCount*bucketSlots<capacity){
+        bucketCount *= 2;
+    }
+    buckets.reset(new Bucket[bucketCount]);
+    mask = bucketCount - 1;
+    clear();
+}
+
+//0 marks the empty slots
+inline uint64_t slotKey(uint64_t hash){
+    return hash ? hash : 1;
+}
+
+inline uint64_t slotEntry(uint64_t key, float fitness){
+    uint32_t bits;
+    std::memcpy(&bits, &fitness, sizeof(bits));
+    return (key & 0xffffffff00000000) | bits;
+}
+
+bool FitnessCache::find(uint64_t hash, float &fitness) const{
+    uint64_t key = slotKey(hash);
+    const Bucket &bucket = buckets[key & mask];
+    for(const Slot &slot : bucket.slots){
+        if(slot.key.load(std::memory_order_acquire)==key){
+            uint64_t entry = slot.entry.load(std::memory_order_relaxed);
+            //A concurrent insertion may have replaced the entry since the key was read
+            if((entry ^ key) >> 32){
+                return false;
+            }
+            uint32_t bits = uint32_t(entry);
+            std::memcpy(&fitness, &bits, sizeof(fitness));
+            return true;
+        }
+    }
+    return false;
+}
+
+void FitnessCache::insert(uint64_t hash, float fitness){
+    uint64_t key = slotKey(hash);
+    Bucket &bucket = buckets[key & mask];
+    //Updates the genome's own slot if it has one, otherwise takes an empty slot, otherwise evicts a pseudo-random one
+    Slot *target = &bucket.slots[(key >> 62) & (bucketSlots - 1)];
+    for(Slot &slot : bucket.slots){
+        uint64_t current = slot.key.load(std::memory_order_relaxed);
+        if(current==key){
+            target = &slot;
+            break;
+        }
+        if(!current && target->key.load(std::memory_order_relaxed)){
+            target = &slot;
+        }
+    }
+    target->entry.store(slotEntry(key, fitness), std::memory_order_relaxed);
+    target->key.store(key, std::memory_order_release);
+}
+
+void FitnessCache::clear(){
+    for(uint64_t b=0;b<=mask;++b){
+        for(Slot &slot : buckets[b].slots){
+            slot.key.store(0, std::memory_order_relaxed);
+            slot.entry.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void FitnessCache::save(std::vector<FitnessCacheEntry> &entries) const{
+    for(uint64_t slot=0;slot<capacity();++slot){
+        const Slot &source = buckets[slot/bucketSlots].slots[slot%bucketSlots];
+        uint64_t key = source.key.load(std::memory_order_relaxed);
+        if(key){
+            uint32_t bits = uint32_t(source.entry.load(std::memory_order_relaxed));
+            float fitness;
+            std::memcpy(&fitness, &bits, sizeof(fitness));
+            entries.push_back({slot, key, fitness});
+        }
+    }
+}
+
+void FitnessCache::restore(const FitnessCacheEntry *entries, uint64_t count){
+    clear();
+    for(uint64_t e=0;e<count;++e){
+        assert(entries[e].slot<capacity() && "FitnessCache::restore: the entries are from a bigger cache.\n");
+        Slot &target = buckets[entries[e].slot/bucketSlots].slots[entries[e].slot%bucketSlots];
+        uint64_t key = slotKey(entries[e].hash);
+        target.entry.store(slotEntry(key, entries[e].fitness), std::memory_order_relaxed);
+        target.key.store(key, std::memory_order_relaxed);
+    }
+}
+
+FitnessMemo::FitnessMemo(FitnessCache &cache, int populationSize) :
+    cache(&cache), hashes(populationSize), known(populationSize), novel(populationSize), distinct(populationSize){
+    assert(populationSize>0 && "FitnessMemo: populationSize must be positive.\n");
+}
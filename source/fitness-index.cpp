@@ -0,0 +1,201 @@
+#include <cassert>
+#include <algorithm>
+#include <fitness-index.hpp>
+#include <genetic-algorithm.hpp>
+
+//The shape of the treap doesn't affect any result, so its priorities don't need to be seeded by the caller
+const uint64_t prioritiesSeed = 0x5eed0f1ade7ull;
+
+FitnessIndex::FitnessIndex(int capacity, bool maximizeFitness) :
+    nodes(capacity), fitnesses(capacity), maximize(maximizeFitness), priorities(prioritiesSeed), workspace(capacity){
+    assert(capacity>0 && "FitnessIndex: capacity must be positive.\n");
+    spine.reserve(capacity);
+    for(Node &node : nodes){
+        node.size = 0;
+    }
+}
+
+void FitnessIndex::update(int node){
+    int left = nodes[node].left;
+    int right = nodes[node].right;
+    nodes[node].size = 1 + (left<0 ? 0 : nodes[left].size) + (right<0 ? 0 : nodes[right].size);
+}
+
+void FitnessIndex::split(int tree, uint64_t key, int &less, int &notLess){
+    if(tree<0){
+        less = notLess = -1;
+        return;
+    }
+    if(nodes[tree].key<key){
+        split(nodes[tree].right, key, nodes[tree].right, notLess);
+        less = tree;
+    } else {
+        split(nodes[tree].left, key, less, nodes[tree].left);
+        notLess = tree;
+    }
+    update(tree);
+}
+
+int FitnessIndex::merge(int less, int greater){
+    if(less<0 || greater<0){
+        return less<0 ? greater : less;
+    }
+    if(nodes[less].priority>nodes[greater].priority){
+        nodes[less].right = merge(nodes[less].right, greater);
+        update(less);
+        return less;
+    }
+    nodes[greater].left = merge(less, nodes[greater].left);
+    update(greater);
+    return greater;
+}
+
+void FitnessIndex::assign(const float *fitness, int populationSize){
+    assert(populationSize>0 && populationSize<=capacity() && "FitnessIndex::assign: populationSize must be positive and at most capacity().\n");
+    for(Node &node : nodes){
+        node.size = 0;
+    }
+    int *ranksLookup = workspace.ranksLookup.data();
+    rankPopulation(fitness, populationSize, maximize, ranksLookup, workspace);
+    //Builds the treap in order of rank, keeping its right spine on a stack. A node is final once it's popped
+    spine.clear();
+    for(int rank=0;rank<populationSize;++rank){
+        int individual = ranksLookup[rank];
+        Node &node = nodes[individual];
+        node.key = rankingKey(fitness[individual], individual, maximize);
+        node.priority = uint32_t(priorities());
+        node.right = -1;
+        int last = -1;
+        while(!spine.empty() && nodes[spine.back()].priority<node.priority){
+            last = spine.back();
+            update(last);
+            spine.pop_back();
+        }
+        node.left = last;
+        if(!spine.empty()){
+            nodes[spine.back()].right = individual;
+        }
+        spine.push_back(individual);
+        fitnesses[individual] = fitness[individual];
+    }
+    //The bottom of the spine has the highest priority of all
+    root = spine.front();
+    while(!spine.empty()){
+        update(spine.back());
+        spine.pop_back();
+    }
+}
+
+void FitnessIndex::insert(int individual, float fitness){
+    assert(individual>=0 && individual<capacity() && "FitnessIndex::insert: individual out of range.\n");
+    assert(!contains(individual) && "FitnessIndex::insert: individual is already in the index.\n");
+    Node &node = nodes[individual];
+    node.key = rankingKey(fitness, individual, maximize);
+    node.priority = uint32_t(priorities());
+    node.left = node.right = -1;
+    node.size = 1;
+    fitnesses[individual] = fitness;
+    int less, notLess;
+    split(root, node.key, less, notLess);
+    root = merge(merge(less, individual), notLess);
+}
+
+void FitnessIndex::remove(int individual){
+    assert(individual>=0 && individual<capacity() && "FitnessIndex::remove: individual out of range.\n");
+    assert(contains(individual) && "FitnessIndex::remove: individual isn't in the index.\n");
+    uint64_t key = nodes[individual].key;
+    int less, notLess, equal, greater;
+    split(root, key, less, notLess);
+    split(notLess, key + 1, equal, greater);
+    assert(equal==individual);
+    nodes[individual].size = 0;
+    root = merge(less, greater);
+}
+
+void FitnessIndex::replace(int individual, float fitness){
+    remove(individual);
+    insert(individual, fitness);
+}
+
+int FitnessIndex::individualAt(int rank) const{
+    assert(rank>=0 && rank<size() && "FitnessIndex::individualAt: rank out of range.\n");
+    int node = root;
+    while(true){
+        int left = nodes[node].left;
+        int leftSize = left<0 ? 0 : nodes[left].size;
+        if(rank<leftSize){
+            node = left;
+        } else if(rank==leftSize){
+            return node;
+        } else {
+            rank -= leftSize + 1;
+            node = nodes[node].right;
+        }
+    }
+}
+
+int FitnessIndex::rankOf(int individual) const{
+    assert(contains(individual) && "FitnessIndex::rankOf: individual isn't in the index.\n");
+    uint64_t key = nodes[individual].key;
+    int rank = 0;
+    int node = root;
+    while(true){
+        int left = nodes[node].left;
+        int leftSize = left<0 ? 0 : nodes[left].size;
+        if(key<nodes[node].key){
+            node = left;
+        } else if(key==nodes[node].key){
+            return rank + leftSize;
+        } else {
+            rank += leftSize + 1;
+            node = nodes[node].right;
+        }
+    }
+}
+
+void linearRanking(const FitnessIndex &index, float selectionPressure, int *winners, int winnersSize, RandomEngine &engine, SamplingMethod method){
+    assert(selectionPressure>1 && selectionPressure<2 && "linearRanking: selectionPressure must be between 1 and 2 , extremes excluded.\n");
+    assert(index.size()>0 && "linearRanking: the index is empty.\n");
+    assert(winners);
+    int populationSize = index.size();
+    SelectionTableCache::Table distribution = linearRankingTable(selectionPressure, populationSize, resolveSamplingMethod(method, populationSize, winnersSize));
+    sampleSelectionDistribution(*distribution, winners, winnersSize, engine);
+    for(int i=0;i<winnersSize;++i){
+        winners[i] = index.individualAt(winners[i]);
+    }
+}
+
+void exponentialRanking(const FitnessIndex &index, float k1, int *winners, int winnersSize, RandomEngine &engine, SamplingMethod method){
+    assert(k1 >= 0.01 && k1 <= 0.1 && "exponentialRanking: k1 must be between 0.01 and 0.1\n");
+    assert(index.size()>0 && "exponentialRanking: the index is empty.\n");
+    assert(winners);
+    int populationSize = index.size();
+    SelectionTableCache::Table distribution = exponentialRankingTable(k1, populationSize, resolveSamplingMethod(method, populationSize, winnersSize));
+    sampleSelectionDistribution(*distribution, winners, winnersSize, engine);
+    for(int i=0;i<winnersSize;++i){
+        winners[i] = index.individualAt(winners[i]);
+    }
+}
+
+void tournamentRanking(const FitnessIndex &index, int tournamentSize, int *winners, int winnersSize, SelectionWorkspace &workspace, RandomEngine &engine){
+    int populationSize = index.size();
+    assert(tournamentSize > 1 && "tournamentRanking: tournamentSize must be greater than 1");
+    assert(tournamentSize < populationSize && "tournamentRanking: tournamentSize must be less than populationSize");
+    assert(winners);
+    int *ranks = workspace.scratch(workspace.contestants, tournamentSize);
+    for(int i=0;i<winnersSize;++i){
+        //Floyd's algorithm over the ranks, the winner is the contestant with the lowest one
+        int best = populationSize;
+        for(int drawn=0;drawn<tournamentSize;++drawn){
+            int j = populationSize - tournamentSize + drawn;
+            int t = engine.bounded(j + 1);
+            ranks[drawn] = std::find(ranks, ranks+drawn, t)==ranks+drawn ? t : j;
+            best = std::min(best, ranks[drawn]);
+        }
+        winners[i] = index.individualAt(best);
+    }
+}
+
+void tournamentRanking(const FitnessIndex &index, int tournamentSize, int *winners, int winnersSize, RandomEngine &engine){
+    tournamentRanking(index, tournamentSize, winners, winnersSize, defaultSelectionWorkspace(), engine);
+}
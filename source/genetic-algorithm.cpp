@@ -1,33 +1,26 @@
 #include <cassert>
 #include <cstdint>
 #include <algorithm>
-#include <random>
+#include <cmath>
 #include <cstring>
-#include <unordered_map>
 #include <vector>
 #include <genetic-algorithm.hpp>
+#include "instrumentation-hooks.hpp"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
-const int storedProbabilities   = 5;
-const int trackedProbabilities  = 10;
-struct RanksData{
-    int populationSize;
-    int usage;
-    float* probabilities;
-};
-
-std::unordered_map<float, std::unordered_map<int, RanksData>> linearRanksData;
-std::unordered_map<float, RanksData> exponentialRanksData;
-
-void rouletteRanking(int populationSize, float *fitness, int *winners, int winnersSize){
-    assert(populationSize && "rouletteRanking: populationSize was 0\n");
-    float *cumulativeProbabilities = new float[populationSize];
+void calculateRouletteProbabilities(int populationSize, float *fitness, float *cumulativeProbabilities){
+    assert(cumulativeProbabilities);
     float minFitness = *std::min_element(fitness, fitness+populationSize);
     if(minFitness>=0){
         cumulativeProbabilities[0] = fitness[0];
         for(int i=1;i<populationSize;++i){
             cumulativeProbabilities[i] = cumulativeProbabilities[i-1] + fitness[i];
         }
-        float reciprocal_sum = 1./fitness[populationSize-1];
+        float reciprocal_sum = 1./cumulativeProbabilities[populationSize-1];
         for (int i=0;i<populationSize;++i){
             cumulativeProbabilities[i] *= reciprocal_sum;
         }
@@ -44,39 +37,40 @@ void rouletteRanking(int populationSize, float *fitness, int *winners, int winne
             cumulativeProbabilities[i] *= reciprocal_sum;
         }
     }
-    std::random_device rd;  
-    std::mt19937 gen(rd()); 
-    std::uniform_real_distribution<> dis(cumulativeProbabilities[0], cumulativeProbabilities[populationSize-1]);
-    if(!winners){
-        winners = new int[winnersSize];
-    }
-    for(int i=0;i<winnersSize;++i){
-        float pick = dis(gen);
-        winners[i] = std::lower_bound(cumulativeProbabilities, cumulativeProbabilities+populationSize, pick) - cumulativeProbabilities; 
-    }
-    delete[] cumulativeProbabilities;
-}
-
-void calculateRanks(float* fitness, int populationSize, bool maximizeFitness, int* ranksLookup){
-    assert(ranksLookup);
-    float *fitnessOrdered = new float[populationSize];
-    std::memcpy(fitnessOrdered, fitness, populationSize*sizeof(float));
-    std::sort(fitnessOrdered, fitnessOrdered+populationSize-1);
-    std::unordered_map<float, int> fitnessMap;
-    fitnessMap.reserve(populationSize);
-    for(int i=0;i<populationSize;++i){
-        fitnessMap[fitness[i]] = i;
-    }
-    if(maximizeFitness){
-        for(int i=0;i<populationSize;++i){
-            ranksLookup[populationSize - 1 - i] = fitnessMap[fitnessOrdered[i]];
-        }
-    } else {
-        for(int i=0;i<populationSize;++i){
-            ranksLookup[i] = fitnessMap[fitnessOrdered[i]];
-        }
-    }
-    delete[] fitnessOrdered;
+}
+
+void rouletteDistribution(int populationSize, float *fitness, SamplingMethod method, SelectionDistribution &distribution){
+    assert(populationSize && "rouletteDistribution: populationSize was 0\n");
+    std::vector<float> cumulativeProbabilities(populationSize);
+    INSTRUMENT_COUNT(Allocations, 1);
+    INSTRUMENT_COUNT(AllocatedBytes, populationSize*sizeof(float));
+    calculateRouletteProbabilities(populationSize, fitness, cumulativeProbabilities.data());
+    buildSelectionDistribution(cumulativeProbabilities.data(), populationSize, method, distribution);
+}
+
+void rouletteDistribution(int populationSize, float *fitness, SamplingMethod method, SelectionWorkspace &workspace){
+    assert(populationSize && "rouletteDistribution: populationSize was 0\n");
+    assert(populationSize<=workspace.capacity() && "rouletteDistribution: populationSize exceeds the workspace's capacity.\n");
+    calculateRouletteProbabilities(populationSize, fitness, workspace.weights.data());
+    buildSelectionDistribution(workspace.weights.data(), populationSize, method, workspace.distribution);
+}
+
+void rouletteRanking(int populationSize, float *fitness, int *winners, int winnersSize, SelectionWorkspace &workspace, RandomEngine &engine, SamplingMethod method){
+    INSTRUMENT_OPERATOR(RouletteRanking);
+    INSTRUMENT_COUNT(Winners, winnersSize);
+    assert(winners);
+    rouletteDistribution(populationSize, fitness, resolveSamplingMethod(method, populationSize, winnersSize), workspace);
+    sampleSelectionDistribution(workspace.distribution, winners, winnersSize, engine);
+}
+
+void rouletteRanking(int populationSize, float *fitness, int *winners, int winnersSize, RandomEngine &engine, SamplingMethod method){
+    SelectionWorkspace &workspace = defaultSelectionWorkspace();
+    workspace.reserve(populationSize);
+    rouletteRanking(populationSize, fitness, winners, winnersSize, workspace, engine, method);
+}
+
+void rouletteRanking(int populationSize, float *fitness, int *winners, int winnersSize){
+    rouletteRanking(populationSize, fitness, winners, winnersSize, defaultRandomEngine());
 }
 
 void calculateLinearRankingProbabilities(float selectionPressure, float *probabilities, int populationSize){
@@ -91,104 +85,45 @@ void calculateLinearRankingProbabilities(float selectionPressure, float *probabi
     }
 }
 
-float* linearRankingProbabilitiesGenerator(float selectionPressure, int populationSize){
-    float* temp_probabilities;
-    auto temp_iterator = linearRanksData.find(selectionPressure);
-    RanksData *temp_data = NULL;
-    int previousRank = 0;
-    if(temp_iterator!=linearRanksData.end()){
-        auto temp_map = temp_iterator->second;
-        auto inner_temp_iterator = temp_map.find(populationSize);
-        if(inner_temp_iterator!=temp_map.end()){
-            temp_data = &linearRanksData[selectionPressure][populationSize]; 
-            for(const auto& m : linearRanksData){
-                for(const auto& data : m.second){
-                    if(data.second.usage>temp_data->usage){
-                        previousRank++;
-                    }
-                }
-            }
-            temp_probabilities = linearRanksData[selectionPressure][populationSize].probabilities;
-            temp_data->usage++;
-        }
-    }
-    if(temp_data!=NULL){
-        int rank=0;
-        RanksData* nextData = temp_data;
-        for(const auto& m : linearRanksData){
-            for(const auto& data : m.second){
-                if(data.second.usage>temp_data->usage){
-                    rank++;
-                } else {
-                    if(data.second.usage>nextData->usage){
-                        nextData = const_cast<RanksData*>(&(data.second));
-                    }
-                }
-            }
-        }
-        if(rank<storedProbabilities){
-            if(previousRank>=storedProbabilities){
-                calculateLinearRankingProbabilities(selectionPressure, temp_probabilities, populationSize);
-                delete[] nextData->probabilities;
-            }
-        }
-    } else {
-        calculateLinearRankingProbabilities(selectionPressure, temp_probabilities, populationSize);
-        bool mustBreak = false;
-        for(const auto& m : linearRanksData){
-            if(mustBreak) {break;}
-            for(const auto& data : m.second){
-                if(data.second.usage==1){
-                    auto mMap = const_cast<std::unordered_map<int, RanksData>*>(&(m.second));
-                    mMap->erase(data.first);
-                    RanksData mRanksData = {1, populationSize, temp_probabilities};
-                    linearRanksData[selectionPressure][populationSize] = mRanksData;
-                    mustBreak = true;
-                    break;
-                }
-            }
-        }
-    }
-    return temp_probabilities;
+void linearRankingDistribution(float selectionPressure, int populationSize, SamplingMethod method, SelectionDistribution &distribution){
+    assert(selectionPressure>1 && selectionPressure<2 && "linearRankingDistribution: selectionPressure must be between 1 and 2 , extremes excluded.\n");
+    std::vector<float> cumulativeProbabilities(populationSize);
+    INSTRUMENT_COUNT(Allocations, 1);
+    INSTRUMENT_COUNT(AllocatedBytes, populationSize*sizeof(float));
+    calculateLinearRankingProbabilities(selectionPressure, cumulativeProbabilities.data(), populationSize);
+    buildSelectionDistribution(cumulativeProbabilities.data(), populationSize, method, distribution);
 }
 
-void deleteProbabilities(float* probabilities, bool linear){
-    bool exists = false;
-    if(linear){
-        for(const auto& m : linearRanksData){
-            for(const auto& data : m.second){
-                if(data.second.probabilities == probabilities){
-                    exists = true;
-                }
-            }
-        }
-    } else {
-        for(const auto& m : exponentialRanksData){
-            if(m.second.probabilities == probabilities){
-                exists = true;
-            }
-        }
-    }
-    if(!exists){
-        delete[] probabilities;
-    }
+SelectionTableCache::Table linearRankingTable(float selectionPressure, int populationSize, SamplingMethod method){
+    SelectionTableKey key = {SelectionScheme::Linear, method, selectionPressure, populationSize};
+    return selectionTableCache().fetch(key, [=](SelectionDistribution &distribution){
+        linearRankingDistribution(selectionPressure, populationSize, method, distribution);
+    });
 }
 
-
-void linearRanking(int populationSize, float *fitness, bool maximizeFitness, float selectionPressure, int *winners, int winnersSize){
+void linearRanking(int populationSize, float *fitness, bool maximizeFitness, float selectionPressure, int *winners, int winnersSize, SelectionWorkspace &workspace, RandomEngine &engine, SamplingMethod method){
+    INSTRUMENT_OPERATOR(LinearRanking);
+    INSTRUMENT_COUNT(Winners, winnersSize);
     assert(selectionPressure>1 && selectionPressure<2 && "linearRanking: selectionPressure must be between 1 and 2 , extremes excluded.\n");
-    int *ranksLookup = new int[populationSize];
-    calculateRanks(fitness, populationSize, maximizeFitness, ranksLookup);
-    float *cumulativeProbabilities = linearRankingProbabilitiesGenerator(selectionPressure, populationSize);
+    assert(populationSize<=workspace.capacity() && "linearRanking: populationSize exceeds the workspace's capacity.\n");
+    int *ranksLookup = workspace.ranksLookup.data();
+    rankPopulation(fitness, populationSize, maximizeFitness, ranksLookup, workspace);
+    SelectionTableCache::Table distribution = linearRankingTable(selectionPressure, populationSize, resolveSamplingMethod(method, populationSize, winnersSize));
     assert(winners);
-    std::random_device rd;  
-    std::mt19937 gen(rd()); 
-    std::uniform_real_distribution<> dis(cumulativeProbabilities[0], cumulativeProbabilities[populationSize-1]);
+    sampleSelectionDistribution(*distribution, winners, winnersSize, engine);
     for(int i=0;i<winnersSize;++i){
-        winners[i] = ranksLookup[std::lower_bound(cumulativeProbabilities, cumulativeProbabilities+populationSize, dis(gen)) - cumulativeProbabilities];
+        winners[i] = ranksLookup[winners[i]];
     }
-    deleteProbabilities(cumulativeProbabilities, true);
-    delete[] ranksLookup;
+}
+
+void linearRanking(int populationSize, float *fitness, bool maximizeFitness, float selectionPressure, int *winners, int winnersSize, RandomEngine &engine, SamplingMethod method){
+    SelectionWorkspace &workspace = defaultSelectionWorkspace();
+    workspace.reserve(populationSize);
+    linearRanking(populationSize, fitness, maximizeFitness, selectionPressure, winners, winnersSize, workspace, engine, method);
+}
+
+void linearRanking(int populationSize, float *fitness, bool maximizeFitness, float selectionPressure, int *winners, int winnersSize){
+    linearRanking(populationSize, fitness, maximizeFitness, selectionPressure, winners, winnersSize, defaultRandomEngine());
 }
 
 void calculateExponentialRankingProbabilities(float k1, float *probabilities, int populationSize, float startingValue, int startingIndex){
@@ -205,167 +140,226 @@ void calculateExponentialRankingProbabilities(float k1, float *probabilities, in
     }
 }
 
-float* exponentialRankingProbabilitiesGenerator(float k1, int populationSize){
-    float* temp_probabilities;
-    auto temp_iterator = exponentialRanksData.find(k1);
-    RanksData *temp_data = NULL;
-    int previousRank = 0;
-    if(temp_iterator!=exponentialRanksData.end()){
-        temp_data = &(temp_iterator->second); 
-            for(const auto& m : exponentialRanksData){
-                if(m.second.usage>temp_data->usage){
-                    previousRank++;
-                }
-            }
-            temp_probabilities = temp_data->probabilities;
-            temp_data->usage++;
-        if(temp_data!=NULL){
-            int rank=0;
-            RanksData* nextData = temp_data;
-            for(const auto& m : exponentialRanksData){
-                if(m.second.usage>temp_data->usage){
-                    rank++;
-                } else {
-                    if(m.second.usage>nextData->usage){
-                        nextData = const_cast<RanksData*>(&(m.second));
-                    }
-                }
-            }
-            if(rank<storedProbabilities){
-                if(previousRank>=storedProbabilities){
-                    calculateExponentialRankingProbabilities(k1, temp_probabilities, populationSize, 0., 0);
-                    delete[] nextData->probabilities;
-                    temp_data->populationSize = populationSize;
-                }
-                else{
-                    int currentPopSize = temp_data->populationSize;
-                    if(populationSize>currentPopSize){
-                        calculateExponentialRankingProbabilities(k1, temp_probabilities, populationSize, temp_probabilities[currentPopSize-1], currentPopSize-1);
-                        temp_data->populationSize = populationSize;
-                    }
-                }
-            }
-        }
-    } 
-    if(temp_data==NULL){
-        calculateExponentialRankingProbabilities(k1, temp_probabilities, populationSize, 0., 0);
-        bool mustBreak = false;
-        for(const auto& m : exponentialRanksData){
-            if(mustBreak) {break;}
-            if(m.second.usage==1){
-                exponentialRanksData.erase(m.first);
-                RanksData mRanksData = {1, populationSize, temp_probabilities};
-                exponentialRanksData[k1] = mRanksData;
-                mustBreak = true;
-                break;
-            }
-        }
-    }
-    return temp_probabilities;
+void exponentialRankingDistribution(float k1, int populationSize, SamplingMethod method, SelectionDistribution &distribution){
+    assert(populationSize>0 && "exponentialRankingDistribution: populationSize must be positive.\n");
+    assert(k1 >= 0.01 && k1 <= 0.1 && "exponentialRankingDistribution: k1 must be between 0.01 and 0.1\n");
+    std::vector<float> cumulativeProbabilities(populationSize);
+    INSTRUMENT_COUNT(Allocations, 1);
+    INSTRUMENT_COUNT(AllocatedBytes, populationSize*sizeof(float));
+    calculateExponentialRankingProbabilities(k1, cumulativeProbabilities.data(), populationSize, 0., 0);
+    buildSelectionDistribution(cumulativeProbabilities.data(), populationSize, method, distribution);
 }
 
+SelectionTableCache::Table exponentialRankingTable(float k1, int populationSize, SamplingMethod method){
+    SelectionTableKey key = {SelectionScheme::Exponential, method, k1, populationSize};
+    return selectionTableCache().fetch(key, [=](SelectionDistribution &distribution){
+        exponentialRankingDistribution(k1, populationSize, method, distribution);
+    });
+}
 
-void exponentialRanking(int populationSize, float *fitness, bool maximizeFitness, float k1, int *winners, int winnersSize){
+void exponentialRanking(int populationSize, float *fitness, bool maximizeFitness, float k1, int *winners, int winnersSize, SelectionWorkspace &workspace, RandomEngine &engine, SamplingMethod method){
+    INSTRUMENT_OPERATOR(ExponentialRanking);
+    INSTRUMENT_COUNT(Winners, winnersSize);
     assert(populationSize>0 && "exponentialRanking: populationSize must be positive.\n");
     assert(k1 >= 0.01 && k1 <= 0.1 && "exponentialRanking: k1 must be between 0.01 and 0.1\n");
-    int *ranksLookup = new int[populationSize];
-    calculateRanks(fitness, populationSize, maximizeFitness, ranksLookup);
-    float* cumulativeProbabilities = exponentialRankingProbabilitiesGenerator(k1, populationSize);
-    if(!winners){
-        winners = new int[winnersSize];
-    }
-    std::random_device rd;  
-    std::mt19937 gen(rd()); 
-    std::uniform_real_distribution<> dis(cumulativeProbabilities[0], cumulativeProbabilities[populationSize-1]);
+    assert(populationSize<=workspace.capacity() && "exponentialRanking: populationSize exceeds the workspace's capacity.\n");
+    assert(winners);
+    int *ranksLookup = workspace.ranksLookup.data();
+    rankPopulation(fitness, populationSize, maximizeFitness, ranksLookup, workspace);
+    SelectionTableCache::Table distribution = exponentialRankingTable(k1, populationSize, resolveSamplingMethod(method, populationSize, winnersSize));
+    sampleSelectionDistribution(*distribution, winners, winnersSize, engine);
     for(int i=0;i<winnersSize;++i){
-        winners[i] = ranksLookup[std::lower_bound(cumulativeProbabilities, cumulativeProbabilities+populationSize, dis(gen)) - cumulativeProbabilities];
+        winners[i] = ranksLookup[winners[i]];
     }
-    deleteProbabilities(cumulativeProbabilities, false);
-    delete[] ranksLookup;
 }
 
-void tournamentRanking(int populationSize, float *fitness, bool maximizeFitness, int tournamentSize, int *winners, int winnersSize){
+void exponentialRanking(int populationSize, float *fitness, bool maximizeFitness, float k1, int *winners, int winnersSize, RandomEngine &engine, SamplingMethod method){
+    SelectionWorkspace &workspace = defaultSelectionWorkspace();
+    workspace.reserve(populationSize);
+    exponentialRanking(populationSize, fitness, maximizeFitness, k1, winners, winnersSize, workspace, engine, method);
+}
+
+void exponentialRanking(int populationSize, float *fitness, bool maximizeFitness, float k1, int *winners, int winnersSize){
+    exponentialRanking(populationSize, fitness, maximizeFitness, k1, winners, winnersSize, defaultRandomEngine());
+}
+
+//Number of tournaments whose contestants are all drawn before any of them is resolved, so that the lookups of a batch don't depend on each other
+const int tournamentBatch = 64;
+
+void drawContestants(int populationSize, int tournamentSize, int *contestants, RandomEngine &engine){
+    //Floyd's algorithm: tournamentSize distinct indices in O(tournamentSize^2), independently of populationSize
+    for(int drawn=0;drawn<tournamentSize;++drawn){
+        int j = populationSize - tournamentSize + drawn;
+        int t = engine.bounded(j + 1);
+        contestants[drawn] = std::find(contestants, contestants+drawn, t)==contestants+drawn ? t : j;
+    }
+}
+
+template<typename Better>
+void runTournaments(int populationSize, int tournamentSize, int *winners, int winnersSize, SelectionWorkspace &workspace, RandomEngine &engine, Better better){
+    int *contestants = workspace.scratch(workspace.contestants, tournamentBatch*tournamentSize);
+    for(int first=0;first<winnersSize;first+=tournamentBatch){
+        int batchSize = std::min(tournamentBatch, winnersSize - first);
+        for(int k=0;k<batchSize;++k){
+            drawContestants(populationSize, tournamentSize, contestants + k*tournamentSize, engine);
+        }
+        for(int k=0;k<batchSize;++k){
+            const int *tournament = contestants + k*tournamentSize;
+            int winner = tournament[0];
+            for(int i=1;i<tournamentSize;++i){
+                if(better(tournament[i], winner)){
+                    winner = tournament[i];
+                }
+            }
+            winners[first + k] = winner;
+        }
+    }
+}
+
+void tournamentRanking(int populationSize, float *fitness, bool maximizeFitness, int tournamentSize, int *winners, int winnersSize, SelectionWorkspace &workspace, RandomEngine &engine){
+    INSTRUMENT_OPERATOR(TournamentRanking);
+    INSTRUMENT_COUNT(Winners, winnersSize);
     assert(tournamentSize > 1 && "tournamentRanking: tournamentSize must be greater than 1");
     assert(tournamentSize < populationSize && "tournamentRanking: tournamentSize must be less than populationSize");
-    int *ranksLookup = new int[populationSize];
-    calculateRanks(fitness, populationSize, maximizeFitness, ranksLookup);
     assert(winners);
-    for(int k=0;k<winnersSize;++k){
-        //Inside-out Fisher-Yattes Shuffle to get a random permutation of [0, populationSize-1]
-        std::random_device rd;  
-        std::mt19937 gen(rd()); 
-        int permutation[populationSize];
-        for(int i=0;i<populationSize;++i){
-            std::uniform_int_distribution<> dis(0, i);
-            int j = dis(gen);
-            if(j!=i){
-                permutation[i] = permutation[j];
+    //The best contestant only depends on the order of the fitnesses, so there's no need to rank the whole population
+    if(maximizeFitness){
+        runTournaments(populationSize, tournamentSize, winners, winnersSize, workspace, engine, [fitness](int a, int b){ return fitness[a] > fitness[b]; });
+    } else {
+        runTournaments(populationSize, tournamentSize, winners, winnersSize, workspace, engine, [fitness](int a, int b){ return fitness[a] < fitness[b]; });
+    }
+}
+
+void tournamentRanking(int populationSize, float *fitness, bool maximizeFitness, int tournamentSize, int *winners, int winnersSize, RandomEngine &engine){
+    tournamentRanking(populationSize, fitness, maximizeFitness, tournamentSize, winners, winnersSize, defaultSelectionWorkspace(), engine);
+}
+
+void tournamentSelection(int populationSize, const int *ranks, int tournamentSize, int *winners, int winnersSize, SelectionWorkspace &workspace, RandomEngine &engine){
+    INSTRUMENT_OPERATOR(TournamentSelection);
+    INSTRUMENT_COUNT(Winners, winnersSize);
+    assert(tournamentSize > 1 && "tournamentSelection: tournamentSize must be greater than 1");
+    assert(tournamentSize < populationSize && "tournamentSelection: tournamentSize must be less than populationSize");
+    assert(ranks);
+    assert(winners);
+    runTournaments(populationSize, tournamentSize, winners, winnersSize, workspace, engine, [ranks](int a, int b){ return ranks[a] < ranks[b]; });
+}
+
+void tournamentSelection(int populationSize, const int *ranks, int tournamentSize, int *winners, int winnersSize, RandomEngine &engine){
+    tournamentSelection(populationSize, ranks, tournamentSize, winners, winnersSize, defaultSelectionWorkspace(), engine);
+}
+
+void tournamentRanking(int populationSize, float *fitness, bool maximizeFitness, int tournamentSize, int *winners, int winnersSize){
+    tournamentRanking(populationSize, fitness, maximizeFitness, tournamentSize, winners, winnersSize, defaultRandomEngine());
+}
+
+void selectBatch(int populationSize, float *fitness, bool maximizeFitness, const SelectionRequest *requests, int requestsSize, SelectionWorkspace &workspace, RandomEngine &engine){
+    INSTRUMENT_OPERATOR(SelectBatch);
+    assert(populationSize>0 && "selectBatch: populationSize must be positive.\n");
+    assert(populationSize<=workspace.capacity() && "selectBatch: populationSize exceeds the workspace's capacity.\n");
+    assert(requests || !requestsSize);
+    bool ranked = false;
+    bool inverted = false;
+    bool rouletteBuilt = false;
+    int *ranksLookup = workspace.ranksLookup.data();
+    int *ranks = workspace.ranks.data();
+    for(int r=0;r<requestsSize;++r){
+        const SelectionRequest &request = requests[r];
+        assert(request.winners);
+        if(request.kind==SelectionKind::Roulette){
+            SamplingMethod method = resolveSamplingMethod(request.method, populationSize, request.winnersSize);
+            if(!rouletteBuilt || workspace.distribution.method!=method){
+                rouletteDistribution(populationSize, fitness, method, workspace);
+                rouletteBuilt = true;
             }
-            permutation[j] = i;
+            sampleSelectionDistribution(workspace.distribution, request.winners, request.winnersSize, engine);
+            INSTRUMENT_COUNT(Winners, request.winnersSize);
+            continue;
+        }
+        if(!ranked){
+            rankPopulation(fitness, populationSize, maximizeFitness, ranksLookup, workspace);
+            ranked = true;
         }
-        winners[k] = permutation[0];
-        for(int i=1;i<tournamentSize;++i){
-            if(winners[k] > permutation[i]){
-                winners[k] = permutation[i];
+        if(request.kind==SelectionKind::Tournament){
+            if(!inverted){
+                for(int rank=0;rank<populationSize;++rank){
+                    ranks[ranksLookup[rank]] = rank;
+                }
+                inverted = true;
             }
+            tournamentSelection(populationSize, ranks, int(request.parameter), request.winners, request.winnersSize, workspace, engine);
+            continue;
+        }
+        SamplingMethod method = resolveSamplingMethod(request.method, populationSize, request.winnersSize);
+        SelectionTableCache::Table distribution = request.kind==SelectionKind::Linear ?
+            linearRankingTable(request.parameter, populationSize, method) : exponentialRankingTable(request.parameter, populationSize, method);
+        sampleSelectionDistribution(*distribution, request.winners, request.winnersSize, engine);
+        INSTRUMENT_COUNT(Winners, request.winnersSize);
+        for(int i=0;i<request.winnersSize;++i){
+            request.winners[i] = ranksLookup[request.winners[i]];
         }
     }
-    for(int i=0;i<winnersSize;++i){
-        winners[i] = ranksLookup[winners[i]];
-    }
-    delete[] ranksLookup;
 }
 
-void twoPointsCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uint8_t *child, uint64_t *genesLoci, int genesLociLength){
+//Views genesLoci as if it started with 0 and ended with length, without copying it
+class LociView{
+public:
+    LociView(const uint64_t *genesLoci, int genesLociLength, uint64_t length) :
+        genesLoci(genesLoci), genesLociLength(genesLociLength), length(length), start(genesLoci[0]!=0 ? 1 : 0),
+        count(genesLociLength + start + (genesLoci[genesLociLength-1]!=length ? 1 : 0)){}
+
+    uint64_t size() const { return count; }
+
+    uint64_t operator[](uint64_t k) const{
+        if(k<start){
+            return 0;
+        }
+        return k - start<uint64_t(genesLociLength) ? genesLoci[k - start] : length;
+    }
+
+private:
+    const uint64_t *genesLoci;
+    int genesLociLength;
+    uint64_t length;
+    uint64_t start;
+    uint64_t count;
+};
+
+void twoPointsCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uint8_t *child, uint64_t *genesLoci, int genesLociLength, RandomEngine &engine){
+   INSTRUMENT_OPERATOR(TwoPointsCrossover);
+   INSTRUMENT_COUNT(BytesCopied, length);
    assert(length>2 && "twoPointsCrossover: can't crossover genomes of size less than 3.\n");
    assert(genesLociLength>2 && "twoPointsCrossover: can't crossover genomes with less than 3 genes.\n");
    assert(std::is_sorted(genesLoci, genesLoci+genesLociLength) && "twoPointsCrossover: genesLoci needs to be sorted in non-descending order.\n");
    assert(child);
-   std::random_device rd;  
-   std::mt19937 gen(rd()); 
-   uint64_t cut1, cut2;
-   if(genesLoci[0]!=0 || genesLoci[genesLociLength-1]!=length){
-       uint64_t start  = genesLoci[0]!=0 ? 1 : 0;
-       uint64_t end    = genesLoci[genesLociLength-1]!=length ? 1 : 0;
-       uint64_t *_genesLoci = new uint64_t[genesLociLength + start + end];
-       _genesLoci[0] = 0;
-       _genesLoci[genesLociLength + start + end - 1] = length;
-       std::memcpy(_genesLoci + start, genesLoci, genesLociLength);
-       std::uniform_int_distribution<> dis(0, genesLociLength + start + end - 1);
-       cut1 = _genesLoci[dis(gen)];
-       do{cut2 = _genesLoci[dis(gen)];} while(cut2==cut1);
-       if(cut1>cut2){
-            uint64_t dummy = cut2;
-            cut2 = cut1;
-            cut1= dummy;
-       }
-       delete[] _genesLoci;
-   } else{
-       std::uniform_int_distribution<> dis(0, genesLociLength - 1);
-       cut1 = genesLoci[dis(gen)];
-       do{cut2 = genesLoci[dis(gen)];} while(cut2==cut1);
-       if(cut1>cut2){
-            uint64_t dummy = cut2;
-            cut2 = cut1;
-            cut1= dummy;
-       }
+   LociView loci(genesLoci, genesLociLength, length);
+   uint32_t lociCount = uint32_t(loci.size());
+   uint64_t cut1 = loci[engine.bounded(lociCount)];
+   uint64_t cut2;
+   do{cut2 = loci[engine.bounded(lociCount)];} while(cut2==cut1);
+   if(cut1>cut2){
+        uint64_t dummy = cut2;
+        cut2 = cut1;
+        cut1= dummy;
    }
    std::memcpy(child, parent1, cut1);
    std::memcpy(child+cut1, parent2+cut1, cut2 - cut1);
    std::memcpy(child+cut2, parent1+cut2, length - cut2);
 }
 
-void twoPointsCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uint8_t *child){
+void twoPointsCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uint8_t *child, uint64_t *genesLoci, int genesLociLength){
+    twoPointsCrossover(parent1, parent2, length, child, genesLoci, genesLociLength, defaultRandomEngine());
+}
+
+void twoPointsCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uint8_t *child, RandomEngine &engine){
+   INSTRUMENT_OPERATOR(TwoPointsCrossover);
+   INSTRUMENT_COUNT(BytesCopied, length);
    assert(length>2 && "twoPointsCrossover: can't crossover genomes of size less than 3.\n");
    assert(child);
-   std::random_device rd;  
-   std::mt19937 gen(rd()); 
-   std::uniform_int_distribution<> dis(1, length-2);
-   int cut1 = dis(gen);
-   int cut2;
-   do{cut2 = dis(gen);} while(cut2==cut1);
+   uint64_t cut1 = 1 + engine.bounded64(length - 2);
+   uint64_t cut2;
+   do{cut2 = 1 + engine.bounded64(length - 2);} while(cut2==cut1);
    if(cut1>cut2){
-        int dummy = cut2;
+        uint64_t dummy = cut2;
         cut2 = cut1;
         cut1= dummy;
    }
@@ -374,54 +368,183 @@ void twoPointsCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uin
    std::memcpy(child+cut2, parent1+cut2, length - cut2);
 }
 
+void twoPointsCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uint8_t *child){
+    twoPointsCrossover(parent1, parent2, length, child, defaultRandomEngine());
+}
+
+
+void uniformCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uint8_t *child, uint64_t *genesLoci, int genesLociLength, RandomEngine &engine){
+    INSTRUMENT_OPERATOR(UniformCrossover);
+    INSTRUMENT_COUNT(BytesCopied, length);
+    assert(std::is_sorted(genesLoci, genesLoci+genesLociLength) && "uniformCrossover: genesLoci needs to be sorted in non-descending order.\n");
+    assert(child);
+    LociView loci(genesLoci, genesLociLength, length);
+    uint64_t genesCount = loci.size() - 1;
+    uint64_t bits = 0;
+    uint64_t first = loci[0];
+    for(uint64_t i=0;i<genesCount;++i){
+        //One random number serves 64 genes
+        if(!(i & 63)){
+            bits = engine();
+        }
+        uint64_t last = loci[i+1];
+        std::memcpy(child + first, (bits & 1) ? parent1 + first : parent2 + first, last - first);
+        bits >>= 1;
+        first = last;
+    }
+}
 
 void uniformCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uint8_t *child, uint64_t *genesLoci, int genesLociLength){
-   assert(std::is_sorted(genesLoci, genesLoci+genesLociLength) && "uniformCrossover: genesLoci needs to be sorted in non-descending order.\n");
+    uniformCrossover(parent1, parent2, length, child, genesLoci, genesLociLength, defaultRandomEngine());
+}
+
+//Returns 64 random bits, each set with probability threshold/65536. Starting from no bits set, each binary digit of the threshold, from
+//the least significant one, either ORs (1) or ANDs (0) a fresh random word in, which halves the distance from 1 or from 0 respectively
+uint64_t randomBits(RandomEngine &engine, uint32_t threshold){
+    if(threshold>=65536){
+        return ~uint64_t(0);
+    }
+    if(!threshold){
+        return 0;
+    }
+    uint64_t bits = 0;
+    //The trailing zeros would only AND into an empty word
+    int digit = 0;
+    while(!((threshold >> digit) & 1)){
+        ++digit;
+    }
+    for(;digit<16;++digit){
+        bits = (threshold >> digit) & 1 ? bits | engine() : bits & engine();
+    }
+    return bits;
+}
+
+//Blends 8 bytes with one bit of mask per byte: a set bit picks parent1
+inline void blendBytes(const uint8_t *parent1, const uint8_t *parent2, uint8_t *child, uint8_t mask){
+    uint64_t spread = (mask*0x0101010101010101ull) & 0x8040201008040201ull;
+    uint64_t byteMask = (((spread + 0x7f7f7f7f7f7f7f7full) | spread) & 0x8080808080808080ull) >> 7;
+    byteMask *= 0xff;
+    uint64_t a, b;
+    std::memcpy(&a, parent1, 8);
+    std::memcpy(&b, parent2, 8);
+    a = (a & byteMask) | (b & ~byteMask);
+    std::memcpy(child, &a, 8);
+}
+
+//Blends 64 bytes with one bit of mask per byte
+inline void blendBlock(const uint8_t *parent1, const uint8_t *parent2, uint8_t *child, uint64_t mask){
+#if defined(__AVX2__)
+    const __m256i shuffle = _mm256_setr_epi64x(0x0000000000000000, 0x0101010101010101, 0x0202020202020202, 0x0303030303030303);
+    const __m256i selector = _mm256_set1_epi64x(0x8040201008040201);
+    for(int half=0;half<2;++half){
+        __m256i bits = _mm256_shuffle_epi8(_mm256_set1_epi32(uint32_t(mask >> (32*half))), shuffle);
+        __m256i byteMask = _mm256_cmpeq_epi8(_mm256_and_si256(bits, selector), selector);
+        __m256i a = _mm256_loadu_si256((const __m256i*)(parent1 + 32*half));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(parent2 + 32*half));
+        _mm256_storeu_si256((__m256i*)(child + 32*half), _mm256_blendv_epi8(b, a, byteMask));
+    }
+#elif defined(__SSE2__)
+    const __m128i selector = _mm_set1_epi64x(0x8040201008040201);
+    for(int quarter=0;quarter<4;++quarter){
+        uint64_t low = (mask >> (16*quarter)) & 0xff;
+        uint64_t high = (mask >> (16*quarter + 8)) & 0xff;
+        __m128i bits = _mm_set_epi64x(high*0x0101010101010101ull, low*0x0101010101010101ull);
+        __m128i byteMask = _mm_cmpeq_epi8(_mm_and_si128(bits, selector), selector);
+        __m128i a = _mm_loadu_si128((const __m128i*)(parent1 + 16*quarter));
+        __m128i b = _mm_loadu_si128((const __m128i*)(parent2 + 16*quarter));
+        _mm_storeu_si128((__m128i*)(child + 16*quarter), _mm_or_si128(_mm_and_si128(byteMask, a), _mm_andnot_si128(byteMask, b)));
+    }
+#else
+    for(int i=0;i<8;++i){
+        blendBytes(parent1 + 8*i, parent2 + 8*i, child + 8*i, uint8_t(mask >> (8*i)));
+    }
+#endif
+}
+
+uint32_t inheritanceThreshold(float parent1Probability){
+    assert(parent1Probability>=0 && parent1Probability<=1 && "uniformCrossover: parent1Probability must be between 0 and 1.\n");
+    return uint32_t(std::lround(parent1Probability*65536.f));
+}
+
+void uniformCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uint8_t *child, float parent1Probability, RandomEngine &engine){
+    INSTRUMENT_OPERATOR(UniformCrossover);
+    INSTRUMENT_COUNT(BytesCopied, length);
     assert(child);
-    std::random_device rd;  
-    std::mt19937 gen(rd()); 
-    std::uniform_int_distribution<uint8_t> dis(0, 1);
-    if(genesLoci[0]!=0 || genesLoci[genesLociLength-1]!=length){
-        uint64_t start  = genesLoci[0]!=0 ? 1 : 0;
-        uint64_t end    = genesLoci[genesLociLength-1]!=length ? 1 : 0;
-        uint64_t *_genesLoci = new uint64_t[genesLociLength + start + end];
-        _genesLoci[0] = 0;
-        _genesLoci[genesLociLength + start + end - 1] = length;
-        std::memcpy(_genesLoci + start, genesLoci, genesLociLength);
-        for(uint64_t i=0;i<genesLociLength + start + end - 1;++i){
-            uint8_t maskBit = dis(gen);
-            std::memcpy(child + _genesLoci[i], maskBit ? parent1 + _genesLoci[i] : parent2 + _genesLoci[i], _genesLoci[i+1] - _genesLoci[i]);
+    uint32_t threshold = inheritanceThreshold(parent1Probability);
+    uint64_t i = 0;
+    for(;i+64<=length;i+=64){
+        blendBlock(parent1 + i, parent2 + i, child + i, randomBits(engine, threshold));
+    }
+    if(i<length){
+        uint64_t mask = randomBits(engine, threshold);
+        for(;i+8<=length;i+=8, mask>>=8){
+            blendBytes(parent1 + i, parent2 + i, child + i, uint8_t(mask));
         }
-        delete[] _genesLoci;
-    } else{
-        for(int i=0;i<genesLociLength-1;++i){
-            uint8_t maskBit = dis(gen);
-            std::memcpy(child + genesLoci[i], maskBit ? parent1 + genesLoci[i] : parent2 + genesLoci[i], genesLoci[i+1] - genesLoci[i]);
+        for(;i<length;++i, mask>>=1){
+            child[i] = mask & 1 ? parent1[i] : parent2[i];
         }
     }
 }
 
-void uniformCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uint8_t *child){
+void uniformCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uint8_t *child, RandomEngine &engine){
+    uniformCrossover(parent1, parent2, length, child, 0.5f, engine);
+}
+
+void packedUniformCrossover(const uint64_t *parent1, const uint64_t *parent2, uint64_t words, uint64_t *child, float parent1Probability, RandomEngine &engine){
+    INSTRUMENT_OPERATOR(PackedUniformCrossover);
+    INSTRUMENT_COUNT(BytesCopied, words*sizeof(uint64_t));
     assert(child);
-    std::random_device rd;  
-    std::mt19937 gen(rd()); 
-    std::uniform_int_distribution<uint8_t> dis(0, 1);
-    for(uint64_t i=0;i<length;++i){
-        uint8_t maskBit = dis(gen);
-        child[i] = parent1[i]*maskBit + parent2[i]*(1 - maskBit);
+    uint32_t threshold = inheritanceThreshold(parent1Probability);
+    for(uint64_t i=0;i<words;++i){
+        uint64_t mask = randomBits(engine, threshold);
+        child[i] = (parent1[i] & mask) | (parent2[i] & ~mask);
     }
 }
 
-void mutate(uint8_t *individual, int length, float mutationProbability){
-    assert(mutationProbability>0 && "mutate: mutationProbability must be greater than 0.\n");
-    assert(mutationProbability<1 && "mutate: mutationProbability must be less than 1.\n");
-    std::random_device rd;  
-    std::mt19937 gen(rd()); 
-    std::uniform_real_distribution<float> prob(0, 1);
-    std::uniform_int_distribution<uint8_t> dis8(0, 7);
-    for(int i=0;i<length;++i){
-        if(prob(gen)<mutationProbability){
-            *individual^= (1<<dis8(gen));
+void uniformCrossover(uint8_t *parent1, uint8_t *parent2, uint64_t length, uint8_t *child){
+    uniformCrossover(parent1, parent2, length, child, defaultRandomEngine());
+}
+
+void mutate(uint8_t *individual, int length, float mutationProbability, RandomEngine &engine){
+    INSTRUMENT_OPERATOR(Mutate);
+    assert(mutationProbability>=0 && mutationProbability<=1 && "mutate: mutationProbability must be between 0 and 1.\n");
+    GeometricSkip skip(mutationProbability);
+    uint64_t end = length;
+    for(uint64_t i=skip.next(engine, end);i<end;i+=1 + skip.next(engine, end)){
+        individual[i] ^= 1 << engine.bounded(8);
+        INSTRUMENT_COUNT(Mutations, 1);
+    }
+}
+
+void packedMutate(uint64_t *individual, uint64_t bits, float mutationProbability, RandomEngine &engine){
+    INSTRUMENT_OPERATOR(PackedMutate);
+    assert(mutationProbability>=0 && mutationProbability<=1 && "packedMutate: mutationProbability must be between 0 and 1.\n");
+    GeometricSkip skip(mutationProbability);
+    for(uint64_t i=skip.next(engine, bits);i<bits;i+=1 + skip.next(engine, bits)){
+        individual[i >> 6] ^= uint64_t(1) << (i & 63);
+        INSTRUMENT_COUNT(Mutations, 1);
+    }
+}
+
+void mutate(uint8_t *individual, uint64_t length, uint64_t *genesLoci, int genesLociLength, float mutationProbability, RandomEngine &engine){
+    INSTRUMENT_OPERATOR(Mutate);
+    assert(mutationProbability>=0 && mutationProbability<=1 && "mutate: mutationProbability must be between 0 and 1.\n");
+    assert(genesLociLength>0 && "mutate: genesLoci must have at least one locus.\n");
+    assert(std::is_sorted(genesLoci, genesLoci+genesLociLength) && "mutate: genesLoci needs to be sorted in non-descending order.\n");
+    LociView loci(genesLoci, genesLociLength, length);
+    uint64_t genesCount = loci.size() - 1;
+    GeometricSkip skip(mutationProbability);
+    for(uint64_t g=skip.next(engine, genesCount);g<genesCount;g+=1 + skip.next(engine, genesCount)){
+        uint64_t first = loci[g];
+        uint64_t geneBits = (loci[g + 1] - first)*8;
+        if(geneBits){
+            uint64_t bit = geneBits<=UINT32_MAX ? engine.bounded(uint32_t(geneBits)) : engine.bounded64(geneBits);
+            individual[first + (bit >> 3)] ^= 1 << (bit & 7);
+            INSTRUMENT_COUNT(Mutations, 1);
         }
     }
 }
+
+void mutate(uint8_t *individual, int length, float mutationProbability){
+    mutate(individual, length, mutationProbability, defaultRandomEngine());
+}
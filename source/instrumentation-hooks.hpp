@@ -0,0 +1,40 @@
+#pragma once
+//The hooks the library's operators report to telemetry through. They're private to the library, so that whether they're compiled in only
+//depends on how the library is built
+#include <chrono>
+#include <cstdint>
+#include <instrumentation.hpp>
+
+#ifdef GENETIC_ALGORITHM_INSTRUMENTATION
+/*!
+ * @brief Adds amount to counter, on the calling thread's counters
+ */
+void countTelemetry(TelemetryCounter counter, uint64_t amount);
+
+/*!
+ * @brief Accounts a call of op that ran from start to end
+ */
+void recordOperator(TelemetryOperator op, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+/*!
+ * @brief Times the scope it lives in as a call of an operator
+ */
+class OperatorTimer{
+public:
+    explicit OperatorTimer(TelemetryOperator op) : op(op), start(std::chrono::steady_clock::now()){}
+    ~OperatorTimer(){ recordOperator(op, start, std::chrono::steady_clock::now()); }
+    OperatorTimer(const OperatorTimer&) = delete;
+    OperatorTimer& operator=(const OperatorTimer&) = delete;
+
+private:
+    TelemetryOperator op;
+    std::chrono::steady_clock::time_point start;
+};
+
+//Both expand to nothing, arguments included, when instrumentation is compiled out
+#define INSTRUMENT_OPERATOR(op) OperatorTimer operatorTimer(TelemetryOperator::op)
+#define INSTRUMENT_COUNT(counter, amount) countTelemetry(TelemetryCounter::counter, uint64_t(amount))
+#else
+#define INSTRUMENT_OPERATOR(op)
+#define INSTRUMENT_COUNT(counter, amount)
+#endif
@@ -0,0 +1,234 @@
+#include <atomic>
+#include <cerrno>
+#include <mutex>
+#include <system_error>
+#include <vector>
+#include "instrumentation-hooks.hpp"
+
+//A timed call, in nanoseconds since the trace started
+struct TraceEvent{
+    TelemetryOperator op;
+    int thread;
+    int64_t start;
+    int64_t duration;
+};
+
+struct ThreadTelemetry;
+
+struct TelemetryRegistry{
+    std::mutex mutex;
+    std::vector<ThreadTelemetry*> threads;
+    TelemetrySnapshot retired;              ///< What the threads that exited had counted
+    TelemetrySnapshot previous;             ///< The totals at the end of the previous generation
+    uint64_t generation = 0;
+    int nextThread = 0;
+    std::vector<TraceEvent> retiredEvents;
+    std::atomic<bool> tracing{false};
+    std::chrono::steady_clock::time_point traceOrigin;
+};
+
+TelemetryRegistry& telemetryRegistry(){
+    static TelemetryRegistry telemetry;
+    return telemetry;
+}
+
+//Each thread counts on its own counters. Only the owner writes, so the increments don't need atomic read-modify-writes, the atomics
+//only make the concurrent reads of telemetryTotals well defined
+struct ThreadTelemetry{
+    std::atomic<uint64_t> calls[telemetryOperatorCount] = {};
+    std::atomic<uint64_t> nanoseconds[telemetryOperatorCount] = {};
+    std::atomic<uint64_t> counters[telemetryCounterCount] = {};
+    std::mutex eventsMutex;
+    std::vector<TraceEvent> events;
+    int thread;
+
+    ThreadTelemetry(){
+        TelemetryRegistry &telemetry = telemetryRegistry();
+        std::lock_guard<std::mutex> lock(telemetry.mutex);
+        thread = telemetry.nextThread++;
+        telemetry.threads.push_back(this);
+    }
+
+    ~ThreadTelemetry(){
+        TelemetryRegistry &telemetry = telemetryRegistry();
+        std::lock_guard<std::mutex> lock(telemetry.mutex);
+        addTo(telemetry.retired);
+        telemetry.retiredEvents.insert(telemetry.retiredEvents.end(), events.begin(), events.end());
+        for(size_t i=0;i<telemetry.threads.size();++i){
+            if(telemetry.threads[i]==this){
+                telemetry.threads[i] = telemetry.threads.back();
+                telemetry.threads.pop_back();
+                break;
+            }
+        }
+    }
+
+    void addTo(TelemetrySnapshot &snapshot) const{
+        for(int i=0;i<telemetryOperatorCount;++i){
+            snapshot.operators[i].calls += calls[i].load(std::memory_order_relaxed);
+            snapshot.operators[i].nanoseconds += nanoseconds[i].load(std::memory_order_relaxed);
+        }
+        for(int i=0;i<telemetryCounterCount;++i){
+            snapshot.counters[i] += counters[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    void clear(){
+        for(int i=0;i<telemetryOperatorCount;++i){
+            calls[i].store(0, std::memory_order_relaxed);
+            nanoseconds[i].store(0, std::memory_order_relaxed);
+        }
+        for(int i=0;i<telemetryCounterCount;++i){
+            counters[i].store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+bool instrumentationEnabled(){
+#ifdef GENETIC_ALGORITHM_INSTRUMENTATION
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifdef GENETIC_ALGORITHM_INSTRUMENTATION
+ThreadTelemetry& threadTelemetry(){
+    thread_local ThreadTelemetry telemetry;
+    return telemetry;
+}
+
+inline void addOwned(std::atomic<uint64_t> &value, uint64_t amount){
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+#endif
+
+//Must be called with the registry locked
+TelemetrySnapshot lockedTotals(TelemetryRegistry &telemetry){
+    TelemetrySnapshot totals = telemetry.retired;
+    totals.generation = 0;
+    for(const ThreadTelemetry *thread : telemetry.threads){
+        thread->addTo(totals);
+    }
+    return totals;
+}
+
+const char* telemetryOperatorName(TelemetryOperator op){
+    static const char *const names[telemetryOperatorCount] = {
+        "rouletteRanking", "linearRanking", "exponentialRanking", "tournamentRanking", "tournamentSelection", "selectBatch", "rankPopulation",
+        "nonDominatedSort", "crowdingDistance", "crowdedTournamentRanking",
+        "twoPointsCrossover", "uniformCrossover", "packedUniformCrossover", "mutate", "packedMutate", "reproduce", "evaluateFitness", "writeCheckpoint"
+    };
+    return names[int(op)];
+}
+
+const char* telemetryCounterName(TelemetryCounter counter){
+    static const char *const names[telemetryCounterCount] = {
+        "winners", "bytes_copied", "mutations", "table_hits", "table_misses", "fitness_hits", "fitness_misses", "allocations", "allocated_bytes"
+    };
+    return names[int(counter)];
+}
+
+#ifdef GENETIC_ALGORITHM_INSTRUMENTATION
+void countTelemetry(TelemetryCounter counter, uint64_t amount){
+    addOwned(threadTelemetry().counters[int(counter)], amount);
+}
+
+void recordOperator(TelemetryOperator op, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end){
+    ThreadTelemetry &thread = threadTelemetry();
+    int64_t duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    addOwned(thread.calls[int(op)], 1);
+    addOwned(thread.nanoseconds[int(op)], uint64_t(duration));
+    TelemetryRegistry &telemetry = telemetryRegistry();
+    if(telemetry.tracing.load(std::memory_order_acquire)){
+        int64_t offset = std::chrono::duration_cast<std::chrono::nanoseconds>(start - telemetry.traceOrigin).count();
+        std::lock_guard<std::mutex> lock(thread.eventsMutex);
+        thread.events.push_back({op, thread.thread, offset, duration});
+    }
+}
+#endif
+
+TelemetrySnapshot telemetryTotals(){
+    TelemetryRegistry &telemetry = telemetryRegistry();
+    std::lock_guard<std::mutex> lock(telemetry.mutex);
+    return lockedTotals(telemetry);
+}
+
+TelemetrySnapshot generationTelemetry(){
+    TelemetryRegistry &telemetry = telemetryRegistry();
+    std::lock_guard<std::mutex> lock(telemetry.mutex);
+    TelemetrySnapshot totals = lockedTotals(telemetry);
+    TelemetrySnapshot generation = totals;
+    for(int i=0;i<telemetryOperatorCount;++i){
+        generation.operators[i].calls -= telemetry.previous.operators[i].calls;
+        generation.operators[i].nanoseconds -= telemetry.previous.operators[i].nanoseconds;
+    }
+    for(int i=0;i<telemetryCounterCount;++i){
+        generation.counters[i] -= telemetry.previous.counters[i];
+    }
+    generation.generation = ++telemetry.generation;
+    telemetry.previous = totals;
+    return generation;
+}
+
+void resetTelemetry(){
+    TelemetryRegistry &telemetry = telemetryRegistry();
+    std::lock_guard<std::mutex> lock(telemetry.mutex);
+    for(ThreadTelemetry *thread : telemetry.threads){
+        thread->clear();
+    }
+    telemetry.retired = TelemetrySnapshot();
+    telemetry.previous = TelemetrySnapshot();
+    telemetry.generation = 0;
+}
+
+void writeTelemetryJson(std::FILE *file, const TelemetrySnapshot &snapshot){
+    std::fprintf(file, "{\"generation\":%llu", (unsigned long long)snapshot.generation);
+    for(int i=0;i<telemetryCounterCount;++i){
+        std::fprintf(file, ",\"%s\":%llu", telemetryCounterName(TelemetryCounter(i)), (unsigned long long)snapshot.counters[i]);
+    }
+    std::fprintf(file, ",\"operators\":{");
+    for(int i=0;i<telemetryOperatorCount;++i){
+        std::fprintf(file, "%s\"%s\":{\"calls\":%llu,\"ns\":%llu}", i ? "," : "", telemetryOperatorName(TelemetryOperator(i)),
+                     (unsigned long long)snapshot.operators[i].calls, (unsigned long long)snapshot.operators[i].nanoseconds);
+    }
+    std::fprintf(file, "}}\n");
+    std::fflush(file);
+}
+
+void startTelemetryTrace(){
+    TelemetryRegistry &telemetry = telemetryRegistry();
+    std::lock_guard<std::mutex> lock(telemetry.mutex);
+    telemetry.traceOrigin = std::chrono::steady_clock::now();
+    telemetry.tracing.store(true, std::memory_order_release);
+}
+
+void stopTelemetryTrace(const std::string &path){
+    TelemetryRegistry &telemetry = telemetryRegistry();
+    std::lock_guard<std::mutex> lock(telemetry.mutex);
+    telemetry.tracing.store(false, std::memory_order_relaxed);
+    std::vector<TraceEvent> events;
+    events.swap(telemetry.retiredEvents);
+    for(ThreadTelemetry *thread : telemetry.threads){
+        std::lock_guard<std::mutex> eventsLock(thread->eventsMutex);
+        events.insert(events.end(), thread->events.begin(), thread->events.end());
+        std::vector<TraceEvent>().swap(thread->events);
+    }
+    std::FILE *file = std::fopen(path.c_str(), "w");
+    if(!file){
+        throw std::system_error(errno, std::generic_category(), "stopTelemetryTrace: couldn't open " + path);
+    }
+    //Complete events, with timestamps and durations in microseconds
+    std::fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for(size_t i=0;i<events.size();++i){
+        const TraceEvent &event = events[i];
+        std::fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"genetic-algorithm\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                     i ? "," : "", telemetryOperatorName(event.op), event.thread, event.start*1e-3, event.duration*1e-3);
+    }
+    std::fprintf(file, "\n]}\n");
+    bool failed = std::ferror(file);
+    int error = errno;
+    if(std::fclose(file) || failed){
+        throw std::system_error(failed ? error : errno, std::generic_category(), "stopTelemetryTrace: couldn't write " + path);
+    }
+}
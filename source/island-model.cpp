@@ -0,0 +1,135 @@
+#include <cassert>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <genetic-algorithm.hpp>
+#include <island-model.hpp>
+#include <thread-pool.hpp>
+
+void migrationTargets(IslandTopology topology, int island, int islands, RandomEngine &engine, std::vector<int> &targets){
+    assert(island>=0 && island<islands && "migrationTargets: island out of range.\n");
+    targets.clear();
+    if(islands<2){
+        return;
+    }
+    if(topology==IslandTopology::Ring){
+        targets.push_back((island + 1)%islands);
+    } else if(topology==IslandTopology::Torus){
+        int rows = 1;
+        for(int r=1;r*r<=islands;++r){
+            if(islands%r==0){
+                rows = r;
+            }
+        }
+        int columns = islands/rows;
+        int row = island/columns;
+        int column = island%columns;
+        int neighbours[4] = {
+            ((row + rows - 1)%rows)*columns + column,
+            ((row + 1)%rows)*columns + column,
+            row*columns + (column + columns - 1)%columns,
+            row*columns + (column + 1)%columns
+        };
+        //Narrow grids wrap onto the same neighbour, or onto the island itself
+        for(int neighbour : neighbours){
+            if(neighbour!=island && std::find(targets.begin(), targets.end(), neighbour)==targets.end()){
+                targets.push_back(neighbour);
+            }
+        }
+    } else {
+        int target = engine.bounded(islands - 1);
+        targets.push_back(target<island ? target : target + 1);
+    }
+}
+
+Island::Island(int id, int islands, const IslandSettings &settings, uint64_t seed) :
+    index(id), islands(islands), settings(settings), engine(seed, uint64_t(id)), genomes(settings.populationSize, settings.genomeLength),
+    fitnesses(settings.populationSize), winners(2*settings.populationSize), ranked(settings.populationSize),
+    record(migrantRecordLength(settings.genomeLength)), workspace(settings.populationSize){
+    assert(id>=0 && id<islands && "Island: id out of range.\n");
+    assert(settings.evaluate && "Island: settings.evaluate is required.\n");
+    assert(settings.select && "Island: settings.select is required.\n");
+    assert(settings.migrationSize>=0 && settings.migrationSize<=settings.populationSize/2 && "Island: migrationSize must be between 0 and half the population.\n");
+    for(int i=0;i<genomes.size();++i){
+        uint8_t *genome = genomes.genome(i);
+        for(uint64_t j=0;j<genomes.genomeLength();++j){
+            genome[j] = uint8_t(engine());
+        }
+    }
+}
+
+void Island::evaluate(){
+    for(int i=0;i<genomes.size();++i){
+        fitnesses[i] = settings.evaluate(genomes.genome(i), genomes.genomeLength());
+    }
+    counters.evaluations += genomes.size();
+    evaluated = true;
+}
+
+void Island::migrate(MigrationTransport &transport){
+    int size = genomes.size();
+    uint64_t length = genomes.genomeLength();
+    MigrantHeader header;
+    header.source = index;
+    //Emigrants are sent before any immigrant replaces them
+    partialRankPopulation(fitnesses.data(), size, settings.maximizeFitness, settings.migrationSize, ranked.data(), workspace);
+    migrationTargets(settings.topology, index, islands, engine, targets);
+    for(int target : targets){
+        for(int k=0;k<settings.migrationSize;++k){
+            header.fitness = fitnesses[ranked[k]];
+            std::memcpy(record.data(), &header, sizeof(header));
+            std::memcpy(record.data() + sizeof(header), genomes.genome(ranked[k]), length);
+            if(transport.send(index, target, record.data())){
+                ++counters.migrantsSent;
+            } else {
+                ++counters.migrantsDropped;
+            }
+        }
+    }
+    //At most half the population is replaced, whatever is left waits for the next migration
+    int replaceable = size/2;
+    partialRankPopulation(fitnesses.data(), size, !settings.maximizeFitness, replaceable, ranked.data(), workspace);
+    for(int k=0;k<replaceable && transport.receive(index, record.data());++k){
+        std::memcpy(&header, record.data(), sizeof(header));
+        fitnesses[ranked[k]] = header.fitness;
+        std::memcpy(genomes.genome(ranked[k]), record.data() + sizeof(header), length);
+        ++counters.migrantsReceived;
+    }
+}
+
+void Island::run(int generations, MigrationTransport &transport){
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int size = genomes.size();
+    for(int g=0;g<generations;++g){
+        if(!evaluated){
+            evaluate();
+        }
+        if(settings.migrationInterval>0 && generation>0 && generation%settings.migrationInterval==0){
+            migrate(transport);
+        }
+        settings.select(size, fitnesses.data(), winners.data(), 2*size, workspace, engine);
+        reproduce(genomes, winners.data(), settings.crossoverKind, settings.mutationRate, engine);
+        evaluated = false;
+        ++generation;
+        ++counters.generations;
+    }
+    //So that fitness() matches population() once run returns
+    if(!evaluated){
+        evaluate();
+    }
+    counters.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+IslandModel::IslandModel(int islands, const IslandSettings &settings, uint64_t seed, uint32_t linkSlots) :
+    transport(islands, migrantRecordLength(settings.genomeLength), linkSlots){
+    assert(islands>0 && "IslandModel: islands must be positive.\n");
+    for(int i=0;i<islands;++i){
+        this->islands.emplace_back(new Island(i, islands, settings, seed));
+    }
+}
+
+void IslandModel::run(int generations, ThreadPool &pool){
+    pool.parallelFor(size(), 1, [&](int64_t chunk, int64_t, int64_t){
+        islands[chunk]->run(generations, transport);
+    });
+}
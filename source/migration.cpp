@@ -0,0 +1,203 @@
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <new>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <migration.hpp>
+
+const uint64_t cacheLine = 64;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "MigrationQueue: the queues need lock-free 64 bits atomics to be shared between processes.");
+
+uint64_t roundToCacheLine(uint64_t length){
+    return (length + cacheLine - 1)/cacheLine*cacheLine;
+}
+
+uint64_t MigrationQueue::footprint(uint64_t recordLength, uint32_t slots){
+    return roundToCacheLine(sizeof(Control)) + roundToCacheLine(recordLength)*slots;
+}
+
+MigrationQueue::MigrationQueue(void *memory, uint64_t recordLength, uint32_t slots, bool initialize) :
+    recordLength(recordLength), recordStride(roundToCacheLine(recordLength)), mask(slots - 1){
+    assert(slots && !(slots & (slots - 1)) && "MigrationQueue: slots must be a power of 2.\n");
+    assert(!(reinterpret_cast<uintptr_t>(memory) & (cacheLine - 1)) && "MigrationQueue: memory must be aligned to a cache line.\n");
+    control = initialize ? new(memory) Control() : static_cast<Control*>(memory);
+    records = static_cast<uint8_t*>(memory) + roundToCacheLine(sizeof(Control));
+}
+
+bool MigrationQueue::push(const uint8_t *record){
+    uint64_t tail = control->tail.value.load(std::memory_order_relaxed);
+    if(tail - control->head.value.load(std::memory_order_acquire)>mask){
+        return false;
+    }
+    std::memcpy(records + (tail & mask)*recordStride, record, recordLength);
+    control->tail.value.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool MigrationQueue::pop(uint8_t *record){
+    uint64_t head = control->head.value.load(std::memory_order_relaxed);
+    if(head==control->tail.value.load(std::memory_order_acquire)){
+        return false;
+    }
+    std::memcpy(record, records + (head & mask)*recordStride, recordLength);
+    control->head.value.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+//Polls the links into to round-robin, starting after the last source that delivered
+bool receiveFromLinks(std::vector<MigrationQueue> &links, int islands, int to, int &nextSource, uint8_t *record){
+    for(int k=0;k<islands;++k){
+        int from = (nextSource + k)%islands;
+        if(links[from*islands + to].pop(record)){
+            nextSource = (from + 1)%islands;
+            return true;
+        }
+    }
+    return false;
+}
+
+InProcessTransport::InProcessTransport(int islands, uint64_t recordLength, uint32_t slots) : islands(islands), nextSource(islands, 0){
+    assert(islands>0 && "InProcessTransport: islands must be positive.\n");
+    uint64_t linkLength = MigrationQueue::footprint(recordLength, slots);
+    memory = static_cast<uint8_t*>(std::aligned_alloc(cacheLine, linkLength*islands*islands));
+    if(!memory){
+        throw std::bad_alloc();
+    }
+    links.reserve(islands*islands);
+    for(int i=0;i<islands*islands;++i){
+        links.emplace_back(memory + i*linkLength, recordLength, slots, true);
+    }
+}
+
+InProcessTransport::~InProcessTransport(){
+    std::free(memory);
+}
+
+bool InProcessTransport::send(int from, int to, const uint8_t *record){
+    return links[from*islands + to].push(record);
+}
+
+bool InProcessTransport::receive(int to, uint8_t *record){
+    return receiveFromLinks(links, islands, to, nextSource[to], record);
+}
+
+SharedMemoryTransport::SharedMemoryTransport(const std::string &name, int islands, uint64_t recordLength, uint32_t slots, bool create) :
+    name(name), owner(create), islands(islands), nextSource(islands, 0){
+    assert(islands>0 && "SharedMemoryTransport: islands must be positive.\n");
+    uint64_t linkLength = MigrationQueue::footprint(recordLength, slots);
+    length = linkLength*islands*islands;
+    int descriptor = shm_open(name.c_str(), create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR, 0600);
+    if(descriptor<0){
+        throw std::system_error(errno, std::generic_category(), "SharedMemoryTransport: couldn't open " + name);
+    }
+    if(create && ftruncate(descriptor, off_t(length))){
+        int error = errno;
+        close(descriptor);
+        shm_unlink(name.c_str());
+        throw std::system_error(error, std::generic_category(), "SharedMemoryTransport: couldn't size " + name);
+    }
+    void *address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    int error = errno;
+    //The mapping keeps the object alive
+    close(descriptor);
+    if(address==MAP_FAILED){
+        if(create){
+            shm_unlink(name.c_str());
+        }
+        throw std::system_error(error, std::generic_category(), "SharedMemoryTransport: couldn't map " + name);
+    }
+    memory = static_cast<uint8_t*>(address);
+    links.reserve(islands*islands);
+    for(int i=0;i<islands*islands;++i){
+        links.emplace_back(memory + i*linkLength, recordLength, slots, create);
+    }
+}
+
+SharedMemoryTransport::~SharedMemoryTransport(){
+    munmap(memory, length);
+    if(owner){
+        shm_unlink(name.c_str());
+    }
+}
+
+bool SharedMemoryTransport::send(int from, int to, const uint8_t *record){
+    return links[from*islands + to].push(record);
+}
+
+bool SharedMemoryTransport::receive(int to, uint8_t *record){
+    return receiveFromLinks(links, islands, to, nextSource[to], record);
+}
+
+SocketTransport::SocketTransport(const std::string &directory, int islands, uint64_t recordLength, const std::vector<int> &localIslands) :
+    directory(directory), recordLength(recordLength), sockets(islands, -1){
+    try{
+        bindSockets(localIslands);
+    } catch(...){
+        closeSockets();
+        throw;
+    }
+}
+
+void SocketTransport::bindSockets(const std::vector<int> &localIslands){
+    int islands = int(sockets.size());
+    for(int island : localIslands){
+        assert(island>=0 && island<islands && "SocketTransport: local island out of range.\n");
+        int descriptor = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if(descriptor<0){
+            throw std::system_error(errno, std::generic_category(), "SocketTransport: couldn't create a socket");
+        }
+        sockets[island] = descriptor;
+        std::string path = socketPath(island);
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if(path.size()>=sizeof(address.sun_path)){
+            throw std::system_error(ENAMETOOLONG, std::generic_category(), "SocketTransport: " + path);
+        }
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        unlink(path.c_str());
+        if(bind(descriptor, reinterpret_cast<sockaddr*>(&address), sizeof(address))){
+            throw std::system_error(errno, std::generic_category(), "SocketTransport: couldn't bind " + path);
+        }
+    }
+}
+
+SocketTransport::~SocketTransport(){
+    closeSockets();
+}
+
+void SocketTransport::closeSockets(){
+    for(int island=0;island<int(sockets.size());++island){
+        if(sockets[island]>=0){
+            close(sockets[island]);
+            unlink(socketPath(island).c_str());
+            sockets[island] = -1;
+        }
+    }
+}
+
+std::string SocketTransport::socketPath(int island) const{
+    return directory + "/island-" + std::to_string(island);
+}
+
+bool SocketTransport::send(int from, int to, const uint8_t *record){
+    assert(sockets[from]>=0 && "SocketTransport::send: from must be a local island.\n");
+    std::string path = socketPath(to);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), std::min(path.size() + 1, sizeof(address.sun_path) - 1));
+    //A full or missing receiver fails right away, as the socket is non-blocking
+    return sendto(sockets[from], record, recordLength, 0, reinterpret_cast<sockaddr*>(&address), sizeof(address))==ssize_t(recordLength);
+}
+
+bool SocketTransport::receive(int to, uint8_t *record){
+    assert(sockets[to]>=0 && "SocketTransport::receive: to must be a local island.\n");
+    return recv(sockets[to], record, recordLength, 0)==ssize_t(recordLength);
+}
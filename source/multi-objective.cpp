@@ -0,0 +1,361 @@
+#include <cassert>
+#include <algorithm>
+#include <limits>
+#include <genetic-algorithm.hpp>
+#include <multi-objective.hpp>
+#include <thread-pool.hpp>
+#include "instrumentation-hooks.hpp"
+
+//Below this many records per thread, the sorts run on the calling thread
+const int parallelParetoRun = 1 << 14;
+
+ParetoWorkspace::ParetoWorkspace(int maxPopulationSize, int maxObjectivesCount) : selection(maxPopulationSize){
+    reserve(maxPopulationSize, maxObjectivesCount);
+}
+
+void ParetoWorkspace::reserve(int populationSize, int objectivesCount){
+    if(populationSize<=maxPopulationSize && objectivesCount<=maxObjectivesCount){
+        return;
+    }
+    maxPopulationSize = std::max(maxPopulationSize, populationSize);
+    maxObjectivesCount = std::max(maxObjectivesCount, objectivesCount);
+    size_t size = size_t(maxPopulationSize);
+    keys.resize(size*maxObjectivesCount);
+    distinctKeys.resize(size*maxObjectivesCount);
+    records.resize(size);
+    recordsSwap.resize(size);
+    frontTails.resize(size);
+    distinctOf.resize(size);
+    levels.resize(size);
+    sweep.resize(size);
+    fronts.resize(size);
+    crowding.resize(size);
+    ranksLookup.resize(size);
+    ranks.resize(size);
+    selection.reserve(maxPopulationSize);
+}
+
+//Maps an objective to a uint32 that sorts in the same order, with the best value first. Adding 0 turns -0 into +0, which compare equal
+inline uint32_t objectiveKey(float value, bool maximizeFitness){
+    return uint32_t(rankingKey(value + 0.f, 0, maximizeFitness) >> 32);
+}
+
+//Runs body over [0, size) in chunks, on pool if there's one and the work is worth it
+template<typename Body>
+void forChunks(int64_t size, ThreadPool *pool, Body body){
+    if(pool && pool->size()>1 && size>=2*parallelParetoRun){
+        pool->parallelFor(size, parallelParetoRun, [&](int64_t, int64_t begin, int64_t end){ body(begin, end); });
+    } else {
+        body(0, size);
+    }
+}
+
+//Sorts records, using swap as the other buffer, and returns whichever of the two holds the result. With a pool, one run per thread is sorted
+//in parallel and the runs are then merged pairwise, also in parallel
+template<typename Less>
+ParetoRecord* sortRecords(ParetoRecord *records, ParetoRecord *swap, int size, Less less, ThreadPool *pool){
+    if(!pool || pool->size()==1 || size<2*parallelParetoRun){
+        std::sort(records, records+size, less);
+        return records;
+    }
+    int64_t run = std::max<int64_t>(parallelParetoRun, (size + pool->size() - 1)/pool->size());
+    pool->parallelFor(size, run, [&](int64_t, int64_t begin, int64_t end){
+        std::sort(records + begin, records + end, less);
+    });
+    for(int64_t width=run;width<size;width*=2){
+        pool->parallelFor(size, 2*width, [&](int64_t, int64_t begin, int64_t end){
+            int64_t middle = std::min(begin + width, end);
+            std::merge(records + begin, records + middle, records + middle, records + end, swap + begin, less);
+        });
+        std::swap(records, swap);
+    }
+    return records;
+}
+
+inline bool recordLess(const ParetoRecord &a, const ParetoRecord &b){
+    return a.key<b.key || (a.key==b.key && a.index<b.index);
+}
+
+//With two objectives, sorted keys are (first << 32) | second. The last member of a front has the best second objective of the front, so it
+//dominates the candidate if any member does. The tails are kept together so that the binary searches stay in cache
+int twoObjectivesFronts(const ParetoRecord *sorted, int populationSize, int *fronts, uint64_t *frontTails){
+    int frontsCount = 0;
+    for(int position=0;position<populationSize;++position){
+        uint64_t key = sorted[position].key;
+        int low = 0;
+        int high = frontsCount;
+        while(low<high){
+            int middle = (low + high)/2;
+            uint64_t tail = frontTails[middle];
+            bool dominated = uint32_t(tail)<uint32_t(key) || (uint32_t(tail)==uint32_t(key) && tail<key);
+            if(dominated){
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        fronts[sorted[position].index] = low;
+        frontTails[low] = key;
+        frontsCount = std::max(frontsCount, low + 1);
+    }
+    return frontsCount;
+}
+
+//Below this many pairs, the dominance sweep compares every pair directly
+const int dominanceBruteForcePairs = 256;
+
+//Jensen's divide and conquer over distinct objective vectors sorted lexicographically: the front of a vector is one more than the highest front
+//among the earlier vectors that are no worse in every objective, which are exactly those that dominate it
+class DominanceSweep{
+public:
+    DominanceSweep(const uint32_t *keys, int objectivesCount, int *levels, int *scratch) :
+        keys(keys), objectivesCount(objectivesCount), levels(levels), scratch(scratch){}
+
+    //Finalizes the levels of the vectors [begin, end), given the contributions of all the earlier ones
+    void solve(int begin, int end){
+        if(end - begin<2){
+            return;
+        }
+        int middle = (begin + end)/2;
+        solve(begin, middle);
+        for(int i=begin;i<end;++i){
+            scratch[i] = i;
+        }
+        contribute(scratch + begin, middle - begin, scratch + middle, end - middle, 1);
+        solve(middle, end);
+    }
+
+private:
+    uint32_t key(int vector, int objective) const { return keys[size_t(vector)*objectivesCount + objective]; }
+
+    bool noWorse(int a, int b, int firstObjective) const{
+        for(int m=firstObjective;m<objectivesCount;++m){
+            if(key(a, m)>key(b, m)){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //Raises the level of each vector of right above those of the vectors of left that are no worse in every objective from objective onwards.
+    //The objectives before it are already known to be no worse
+    void contribute(int *left, int leftSize, int *right, int rightSize, int objective){
+        if(!leftSize || !rightSize){
+            return;
+        }
+        if(objective==objectivesCount){
+            int best = levels[*std::max_element(left, left+leftSize, [this](int a, int b){ return levels[a]<levels[b]; })];
+            for(int r=0;r<rightSize;++r){
+                levels[right[r]] = std::max(levels[right[r]], best + 1);
+            }
+            return;
+        }
+        if(leftSize*int64_t(rightSize)<=dominanceBruteForcePairs){
+            for(int r=0;r<rightSize;++r){
+                for(int l=0;l<leftSize;++l){
+                    if(levels[left[l]]>=levels[right[r]] && noWorse(left[l], right[r], objective)){
+                        levels[right[r]] = levels[left[l]] + 1;
+                    }
+                }
+            }
+            return;
+        }
+        auto byObjective = [this, objective](int a, int b){ return key(a, objective)<key(b, objective) || (key(a, objective)==key(b, objective) && a<b); };
+        std::sort(left, left+leftSize, byObjective);
+        std::sort(right, right+rightSize, byObjective);
+        if(objective==objectivesCount - 1){
+            int best = -1;
+            for(int r=0, l=0;r<rightSize;++r){
+                for(;l<leftSize && key(left[l], objective)<=key(right[r], objective);++l){
+                    best = std::max(best, levels[left[l]]);
+                }
+                levels[right[r]] = std::max(levels[right[r]], best + 1);
+            }
+            return;
+        }
+        //Splits both sides at the median of objective, a left vector going first on ties, so that every left vector of the lower half is no
+        //worse in objective than every right vector of the upper half, and no left vector of the upper half is no worse than a right one of
+        //the lower half
+        int half = (leftSize + rightSize)/2;
+        int l = 0;
+        int r = 0;
+        while(l + r<half){
+            if(r==rightSize || (l<leftSize && key(left[l], objective)<=key(right[r], objective))){
+                ++l;
+            } else {
+                ++r;
+            }
+        }
+        contribute(left, l, right, r, objective);
+        contribute(left + l, leftSize - l, right + r, rightSize - r, objective);
+        contribute(left, l, right + r, rightSize - r, objective + 1);
+    }
+
+    const uint32_t *keys;
+    int objectivesCount;
+    int *levels;
+    int *scratch;
+};
+
+int manyObjectivesFronts(const ParetoRecord *sorted, const uint32_t *keys, int objectivesCount, int populationSize, int *fronts, uint32_t *distinctKeys, int *distinctOf, int *levels, int *scratch){
+    //Identical vectors don't dominate each other, so they're merged, and any earlier vector no worse in every objective dominates a later one
+    int distinct = 0;
+    for(int position=0;position<populationSize;++position){
+        const uint32_t *vector = keys + size_t(sorted[position].index)*objectivesCount;
+        uint32_t *last = distinctKeys + size_t(distinct - 1)*objectivesCount;
+        if(!distinct || !std::equal(vector, vector+objectivesCount, last)){
+            std::copy(vector, vector+objectivesCount, last + objectivesCount);
+            levels[distinct++] = 0;
+        }
+        distinctOf[position] = distinct - 1;
+    }
+    DominanceSweep(distinctKeys, objectivesCount, levels, scratch).solve(0, distinct);
+    int frontsCount = 0;
+    for(int position=0;position<populationSize;++position){
+        int front = levels[distinctOf[position]];
+        fronts[sorted[position].index] = front;
+        frontsCount = std::max(frontsCount, front + 1);
+    }
+    return frontsCount;
+}
+
+int sortIntoFronts(const float *objectives, int objectivesCount, int populationSize, bool maximizeFitness, int *fronts, ParetoWorkspace &workspace, ThreadPool *pool){
+    INSTRUMENT_OPERATOR(NonDominatedSort);
+    assert(objectivesCount>0 && "nonDominatedSort: objectivesCount must be positive.\n");
+    assert(populationSize>0 && "nonDominatedSort: populationSize must be positive.\n");
+    assert(populationSize<=workspace.capacity() && objectivesCount<=workspace.objectivesCapacity() && "nonDominatedSort: the population exceeds the workspace's capacity.\n");
+    assert(fronts);
+    ParetoRecord *records = workspace.records.data();
+    uint32_t *keys = workspace.keys.data();
+    forChunks(populationSize, pool, [&](int64_t begin, int64_t end){
+        for(int64_t i=begin;i<end;++i){
+            for(int m=0;m<objectivesCount;++m){
+                keys[i*objectivesCount + m] = objectiveKey(objectives[m*int64_t(populationSize) + i], maximizeFitness);
+            }
+            uint64_t second = objectivesCount>1 ? keys[i*objectivesCount + 1] : 0;
+            records[i] = {(uint64_t(keys[i*objectivesCount]) << 32) | second, int(i)};
+        }
+    });
+    const ParetoRecord *sorted;
+    if(objectivesCount<=2){
+        sorted = sortRecords(records, workspace.recordsSwap.data(), populationSize, recordLess, pool);
+        if(objectivesCount==2){
+            return twoObjectivesFronts(sorted, populationSize, fronts, workspace.frontTails.data());
+        }
+    } else {
+        //The first two objectives are in the key, the others break its ties
+        sorted = sortRecords(records, workspace.recordsSwap.data(), populationSize, [keys, objectivesCount](const ParetoRecord &a, const ParetoRecord &b){
+            if(a.key!=b.key){
+                return a.key<b.key;
+            }
+            const uint32_t *x = keys + size_t(a.index)*objectivesCount;
+            const uint32_t *y = keys + size_t(b.index)*objectivesCount;
+            for(int m=2;m<objectivesCount;++m){
+                if(x[m]!=y[m]){
+                    return x[m]<y[m];
+                }
+            }
+            return a.index<b.index;
+        }, pool);
+    }
+    return manyObjectivesFronts(sorted, keys, objectivesCount, populationSize, fronts, workspace.distinctKeys.data(), workspace.distinctOf.data(),
+                                workspace.levels.data(), workspace.sweep.data());
+}
+
+int nonDominatedSort(const float *objectives, int objectivesCount, int populationSize, bool maximizeFitness, int *fronts, ParetoWorkspace &workspace){
+    return sortIntoFronts(objectives, objectivesCount, populationSize, maximizeFitness, fronts, workspace, NULL);
+}
+
+int nonDominatedSort(const float *objectives, int objectivesCount, int populationSize, bool maximizeFitness, int *fronts, ParetoWorkspace &workspace, ThreadPool &pool){
+    return sortIntoFronts(objectives, objectivesCount, populationSize, maximizeFitness, fronts, workspace, &pool);
+}
+
+void computeCrowdingDistance(const float *objectives, int objectivesCount, int populationSize, const int *fronts, float *distances, ParetoWorkspace &workspace, ThreadPool *pool){
+    INSTRUMENT_OPERATOR(CrowdingDistance);
+    assert(populationSize>0 && "crowdingDistance: populationSize must be positive.\n");
+    assert(populationSize<=workspace.capacity() && "crowdingDistance: populationSize exceeds the workspace's capacity.\n");
+    assert(fronts);
+    assert(distances);
+    const float infinity = std::numeric_limits<float>::infinity();
+    std::fill(distances, distances+populationSize, 0.f);
+    ParetoRecord *records = workspace.records.data();
+    for(int m=0;m<objectivesCount;++m){
+        const float *values = objectives + m*int64_t(populationSize);
+        //Sorting by front, then by objective, makes each front a contiguous run
+        forChunks(populationSize, pool, [&](int64_t begin, int64_t end){
+            for(int64_t i=begin;i<end;++i){
+                records[i] = {(uint64_t(fronts[i]) << 32) | objectiveKey(values[i], false), int(i)};
+            }
+        });
+        const ParetoRecord *sorted = sortRecords(records, workspace.recordsSwap.data(), populationSize, recordLess, pool);
+        for(int first=0;first<populationSize;){
+            int last = first;
+            while(last + 1<populationSize && (sorted[last + 1].key >> 32)==(sorted[first].key >> 32)){
+                ++last;
+            }
+            distances[sorted[first].index] = infinity;
+            distances[sorted[last].index] = infinity;
+            float extent = values[sorted[last].index] - values[sorted[first].index];
+            if(extent>0){
+                for(int k=first+1;k<last;++k){
+                    distances[sorted[k].index] += (values[sorted[k + 1].index] - values[sorted[k - 1].index])/extent;
+                }
+            }
+            first = last + 1;
+        }
+    }
+}
+
+void crowdingDistance(const float *objectives, int objectivesCount, int populationSize, const int *fronts, float *distances, ParetoWorkspace &workspace){
+    computeCrowdingDistance(objectives, objectivesCount, populationSize, fronts, distances, workspace, NULL);
+}
+
+void crowdingDistance(const float *objectives, int objectivesCount, int populationSize, const int *fronts, float *distances, ParetoWorkspace &workspace, ThreadPool &pool){
+    computeCrowdingDistance(objectives, objectivesCount, populationSize, fronts, distances, workspace, &pool);
+}
+
+void rankCrowded(const float *objectives, int objectivesCount, int populationSize, bool maximizeFitness, int *ranksLookup, ParetoWorkspace &workspace, ThreadPool *pool){
+    assert(ranksLookup);
+    int *fronts = workspace.fronts.data();
+    float *crowding = workspace.crowding.data();
+    sortIntoFronts(objectives, objectivesCount, populationSize, maximizeFitness, fronts, workspace, pool);
+    computeCrowdingDistance(objectives, objectivesCount, populationSize, fronts, crowding, workspace, pool);
+    ParetoRecord *records = workspace.records.data();
+    forChunks(populationSize, pool, [&](int64_t begin, int64_t end){
+        for(int64_t i=begin;i<end;++i){
+            records[i] = {(uint64_t(fronts[i]) << 32) | objectiveKey(crowding[i], true), int(i)};
+        }
+    });
+    const ParetoRecord *sorted = sortRecords(records, workspace.recordsSwap.data(), populationSize, recordLess, pool);
+    for(int rank=0;rank<populationSize;++rank){
+        ranksLookup[rank] = sorted[rank].index;
+    }
+}
+
+void crowdedRanking(const float *objectives, int objectivesCount, int populationSize, bool maximizeFitness, int *ranksLookup, ParetoWorkspace &workspace){
+    rankCrowded(objectives, objectivesCount, populationSize, maximizeFitness, ranksLookup, workspace, NULL);
+}
+
+void crowdedRanking(const float *objectives, int objectivesCount, int populationSize, bool maximizeFitness, int *ranksLookup, ParetoWorkspace &workspace, ThreadPool &pool){
+    rankCrowded(objectives, objectivesCount, populationSize, maximizeFitness, ranksLookup, workspace, &pool);
+}
+
+void runCrowdedTournaments(int populationSize, const float *objectives, int objectivesCount, bool maximizeFitness, int tournamentSize, int *winners, int winnersSize, ParetoWorkspace &workspace,
+                           ThreadPool *pool, RandomEngine &engine){
+    INSTRUMENT_OPERATOR(CrowdedTournamentRanking);
+    int *ranksLookup = workspace.ranksLookup.data();
+    int *ranks = workspace.ranks.data();
+    rankCrowded(objectives, objectivesCount, populationSize, maximizeFitness, ranksLookup, workspace, pool);
+    for(int rank=0;rank<populationSize;++rank){
+        ranks[ranksLookup[rank]] = rank;
+    }
+    tournamentSelection(populationSize, ranks, tournamentSize, winners, winnersSize, workspace.selection, engine);
+}
+
+void crowdedTournamentRanking(int populationSize, const float *objectives, int objectivesCount, bool maximizeFitness, int tournamentSize, int *winners, int winnersSize, ParetoWorkspace &workspace, RandomEngine &engine){
+    runCrowdedTournaments(populationSize, objectives, objectivesCount, maximizeFitness, tournamentSize, winners, winnersSize, workspace, NULL, engine);
+}
+
+void crowdedTournamentRanking(int populationSize, const float *objectives, int objectivesCount, bool maximizeFitness, int tournamentSize, int *winners, int winnersSize, ParetoWorkspace &workspace, ThreadPool &pool, RandomEngine &engine){
+    runCrowdedTournaments(populationSize, objectives, objectivesCount, maximizeFitness, tournamentSize, winners, winnersSize, workspace, &pool, engine);
+}
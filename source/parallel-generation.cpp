@@ -0,0 +1,64 @@
+#include <cassert>
+#include <algorithm>
+#include <parallel-generation.hpp>
+
+//Draws winners[i] = lookup(distribution.sample()) in parallel, each chunk from its own stream. Stochastic universal sampling shares a
+//single offset instead, each chunk resolving its own range of pointers, and is shuffled once all of them are
+template<typename Lookup>
+void sampleInParallel(const SelectionDistribution &distribution, int *winners, int winnersSize, ThreadPool &pool, RandomEngine &engine, Lookup lookup){
+    if(distribution.method==SamplingMethod::Universal){
+        double offset = engine.uniformDouble();
+        pool.parallelFor(winnersSize, parallelSelectionGrain, [&](int64_t, int64_t begin, int64_t end){
+            sampleUniversal(distribution, offset, int(begin), int(end - begin), winnersSize, winners + begin);
+            for(int64_t i=begin;i<end;++i){
+                winners[i] = lookup(winners[i]);
+            }
+        });
+        shuffleWinners(winners, winnersSize, engine);
+        return;
+    }
+    uint64_t seed = engine();
+    pool.parallelFor(winnersSize, parallelSelectionGrain, [&](int64_t chunk, int64_t begin, int64_t end){
+        RandomEngine chunkEngine(seed, chunk);
+        for(int64_t i=begin;i<end;++i){
+            winners[i] = lookup(distribution.sample(chunkEngine));
+        }
+    });
+}
+
+void rouletteRanking(int populationSize, float *fitness, int *winners, int winnersSize, SelectionWorkspace &workspace, ThreadPool &pool, RandomEngine &engine, SamplingMethod method){
+    assert(winners);
+    rouletteDistribution(populationSize, fitness, resolveSamplingMethod(method, populationSize, winnersSize), workspace);
+    sampleInParallel(workspace.distribution, winners, winnersSize, pool, engine, [](int i){ return i; });
+}
+
+void linearRanking(int populationSize, float *fitness, bool maximizeFitness, float selectionPressure, int *winners, int winnersSize, SelectionWorkspace &workspace, ThreadPool &pool, RandomEngine &engine, SamplingMethod method){
+    assert(selectionPressure>1 && selectionPressure<2 && "linearRanking: selectionPressure must be between 1 and 2 , extremes excluded.\n");
+    assert(populationSize<=workspace.capacity() && "linearRanking: populationSize exceeds the workspace's capacity.\n");
+    assert(winners);
+    const int *ranksLookup = workspace.ranksLookup.data();
+    rankPopulation(fitness, populationSize, maximizeFitness, workspace.ranksLookup.data(), workspace, pool);
+    SelectionTableCache::Table distribution = linearRankingTable(selectionPressure, populationSize, resolveSamplingMethod(method, populationSize, winnersSize));
+    sampleInParallel(*distribution, winners, winnersSize, pool, engine, [ranksLookup](int rank){ return ranksLookup[rank]; });
+}
+
+void exponentialRanking(int populationSize, float *fitness, bool maximizeFitness, float k1, int *winners, int winnersSize, SelectionWorkspace &workspace, ThreadPool &pool, RandomEngine &engine, SamplingMethod method){
+    assert(populationSize>0 && "exponentialRanking: populationSize must be positive.\n");
+    assert(k1 >= 0.01 && k1 <= 0.1 && "exponentialRanking: k1 must be between 0.01 and 0.1\n");
+    assert(populationSize<=workspace.capacity() && "exponentialRanking: populationSize exceeds the workspace's capacity.\n");
+    assert(winners);
+    const int *ranksLookup = workspace.ranksLookup.data();
+    rankPopulation(fitness, populationSize, maximizeFitness, workspace.ranksLookup.data(), workspace, pool);
+    SelectionTableCache::Table distribution = exponentialRankingTable(k1, populationSize, resolveSamplingMethod(method, populationSize, winnersSize));
+    sampleInParallel(*distribution, winners, winnersSize, pool, engine, [ranksLookup](int rank){ return ranksLookup[rank]; });
+}
+
+void tournamentRanking(int populationSize, float *fitness, bool maximizeFitness, int tournamentSize, int *winners, int winnersSize, ThreadPool &pool, RandomEngine &engine){
+    assert(winners);
+    uint64_t seed = engine();
+    pool.parallelFor(winnersSize, parallelSelectionGrain, [&](int64_t chunk, int64_t begin, int64_t end){
+        RandomEngine chunkEngine(seed, chunk);
+        //Each of the pool's threads has its own default workspace
+        tournamentRanking(populationSize, fitness, maximizeFitness, tournamentSize, winners + begin, int(end - begin), defaultSelectionWorkspace(), chunkEngine);
+    });
+}
@@ -0,0 +1,462 @@
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <genetic-algorithm.hpp>
+#include <population.hpp>
+#include <parallel-generation.hpp>
+#include "instrumentation-hooks.hpp"
+
+const uint64_t cacheLine = 64;
+const uint64_t hugePage = 2*1024*1024;
+//How many pairs ahead of the one being reproduced the parents of mapped populations are read
+const int prefetchDistance = 8;
+
+//A population file is this header followed by the three arenas, each starting on a huge page: the current one, the next one and the spare
+//one, in any order. The spare one stays sparse until a pinned arena is traded for it
+struct PopulationFileHeader{
+    char magic[8];
+    uint64_t version;
+    uint64_t size;
+    uint64_t genomeLength;
+    uint64_t stride;
+    uint64_t current;       ///< The index in the file of the current arena
+};
+const char populationFileMagic[8] = {'G', 'A', 'P', 'O', 'P', 'U', 'L', '\0'};
+const uint64_t populationFileVersion = 2;
+const int populationFileArenas = 3;
+
+uint64_t arenaLength(uint64_t stride, int size){
+    return (stride*size + hugePage - 1)/hugePage*hugePage;
+}
+
+[[noreturn]] void throwSystemError(const std::string &what, int descriptor = -1){
+    int error = errno;
+    if(descriptor>=0){
+        close(descriptor);
+    }
+    throw std::system_error(error, std::generic_category(), what);
+}
+
+Population::Population(int size, uint64_t genomeLength) : individuals(size), length(genomeLength){
+    assert(size>0 && "Population: size must be positive.\n");
+    assert(genomeLength>0 && "Population: genomeLength must be positive.\n");
+    genomeStride = (genomeLength + cacheLine - 1)/cacheLine*cacheLine;
+    for(int i=0;i<2;++i){
+        buffers[i] = static_cast<uint8_t*>(std::aligned_alloc(cacheLine, genomeStride*size));
+        assert(buffers[i] && "Population: couldn't allocate the genomes.\n");
+    }
+    schedule.resize(size);
+    INSTRUMENT_COUNT(Allocations, 3);
+    INSTRUMENT_COUNT(AllocatedBytes, 2*genomeStride*size + size*sizeof(uint64_t));
+}
+
+Population::Population(int size, uint64_t genomeLength, const std::string &path) : individuals(size), length(genomeLength){
+    assert(size>0 && "Population: size must be positive.\n");
+    assert(genomeLength>0 && "Population: genomeLength must be positive.\n");
+    genomeStride = (genomeLength + cacheLine - 1)/cacheLine*cacheLine;
+    int descriptor = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(descriptor<0){
+        throwSystemError("Population: couldn't create " + path);
+    }
+    uint64_t fileLength = hugePage + populationFileArenas*arenaLength(genomeStride, size);
+    if(ftruncate(descriptor, off_t(fileLength))){
+        throwSystemError("Population: couldn't size " + path, descriptor);
+    }
+    map(descriptor, fileLength);
+    PopulationFileHeader header;
+    std::memcpy(header.magic, populationFileMagic, sizeof(header.magic));
+    header.version = populationFileVersion;
+    header.size = uint64_t(size);
+    header.genomeLength = genomeLength;
+    header.stride = genomeStride;
+    header.current = 0;
+    std::memcpy(mapping, &header, sizeof(header));
+    schedule.resize(size);
+    INSTRUMENT_COUNT(Allocations, 1);
+    INSTRUMENT_COUNT(AllocatedBytes, size*sizeof(uint64_t));
+}
+
+Population::Population(const std::string &path){
+    int descriptor = open(path.c_str(), O_RDWR);
+    if(descriptor<0){
+        throwSystemError("Population: couldn't open " + path);
+    }
+    PopulationFileHeader header;
+    struct stat status;
+    if(fstat(descriptor, &status)){
+        throwSystemError("Population: couldn't stat " + path, descriptor);
+    }
+    if(uint64_t(status.st_size)<hugePage || pread(descriptor, &header, sizeof(header), 0)!=ssize_t(sizeof(header)) ||
+       std::memcmp(header.magic, populationFileMagic, sizeof(header.magic)) || header.version!=populationFileVersion ||
+       !header.size || header.size>uint64_t(INT32_MAX) || header.current>=uint64_t(populationFileArenas) ||
+       !header.genomeLength || header.stride<header.genomeLength || header.stride%cacheLine || header.stride>uint64_t(INT64_MAX)/(populationFileArenas*header.size) ||
+       uint64_t(status.st_size)!=hugePage + populationFileArenas*arenaLength(header.stride, int(header.size))){
+        close(descriptor);
+        throw std::runtime_error("Population: " + path + " isn't a population file.");
+    }
+    individuals = int(header.size);
+    length = header.genomeLength;
+    genomeStride = header.stride;
+    map(descriptor, uint64_t(status.st_size));
+    //The next arena's content doesn't matter, so the other two can take either role
+    uint8_t *arenas[populationFileArenas] = {buffers[0], buffers[1], spare};
+    buffers[0] = arenas[header.current];
+    buffers[1] = arenas[(header.current + 1)%populationFileArenas];
+    spare = arenas[(header.current + 2)%populationFileArenas];
+    schedule.resize(individuals);
+    INSTRUMENT_COUNT(Allocations, 1);
+    INSTRUMENT_COUNT(AllocatedBytes, individuals*sizeof(uint64_t));
+}
+
+void Population::map(int descriptor, uint64_t fileLength){
+    void *address = mmap(nullptr, fileLength, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    if(address==MAP_FAILED){
+        throwSystemError("Population: couldn't map the population file", descriptor);
+    }
+    file = descriptor;
+    mapping = static_cast<uint8_t*>(address);
+    mappingLength = fileLength;
+#ifdef MADV_HUGEPAGE
+    //Only honoured by filesystems that support huge pages, harmless elsewhere
+    madvise(mapping, mappingLength, MADV_HUGEPAGE);
+#endif
+    buffers[0] = mapping + hugePage;
+    buffers[1] = buffers[0] + arenaLength(genomeStride, individuals);
+    spare = buffers[1] + arenaLength(genomeStride, individuals);
+}
+
+Population::~Population(){
+    if(pinned){
+        pinned->detach();
+    }
+    if(mapping){
+        munmap(mapping, mappingLength);
+        close(file);
+        return;
+    }
+    std::free(buffers[0]);
+    std::free(buffers[1]);
+    std::free(spare);
+}
+
+void Population::flush(){
+    if(!mapping){
+        return;
+    }
+    reinterpret_cast<PopulationFileHeader*>(mapping)->current = uint64_t(buffers[current] - (mapping + hugePage))/arenaLength(genomeStride, individuals);
+    if(msync(mapping, mappingLength, MS_SYNC)){
+        throwSystemError("Population: couldn't write the population file");
+    }
+}
+
+std::shared_ptr<PinnedGenomes> Population::pin(){
+    if(pinned){
+        //The previous reader may still be in the spare arena, which this pin would need
+        std::lock_guard<std::mutex> lock(pinned->mutex);
+        assert(pinned->released && "Population::pin: the genomes are already pinned.\n");
+    }
+    if(!spare){
+        spare = static_cast<uint8_t*>(std::aligned_alloc(cacheLine, genomeStride*individuals));
+        assert(spare && "Population::pin: couldn't allocate the spare arena.\n");
+        INSTRUMENT_COUNT(Allocations, 1);
+        INSTRUMENT_COUNT(AllocatedBytes, genomeStride*individuals);
+    }
+    pinned.reset(new PinnedGenomes(buffers[current], individuals, length, genomeStride));
+    return pinned;
+}
+
+void Population::unpin(){
+    std::unique_lock<std::mutex> lock(pinned->mutex);
+    if(pinned->released || pinned->unread==pinned->individuals){
+        lock.unlock();
+        pinned.reset();
+        return;
+    }
+    //The pinned arena has just become the next one, which reproduce would overwrite: the spare one takes its place and the reader keeps it
+    //until it releases it. A reader that outlasts more swaps is already out of the way
+    if(!pinned->spared){
+        std::swap(buffers[current ^ 1], spare);
+        pinned->spared = true;
+    }
+}
+
+PinnedGenomes::PinnedGenomes(const uint8_t *genomes, int size, uint64_t genomeLength, uint64_t stride) :
+    genomes(genomes), step(stride), individuals(size), length(genomeLength){}
+
+PinnedGenomes::~PinnedGenomes(){
+    std::free(copy);
+}
+
+void PinnedGenomes::read(int begin, int end, const std::function<void(int, const uint8_t*)> &visit){
+    std::lock_guard<std::mutex> lock(mutex);
+    assert(begin>=unread && end<=individuals && "PinnedGenomes::read: the range was already read or is out of bounds.\n");
+    for(int i=begin;i<end;++i){
+        visit(i, genomes + (i - first)*step);
+    }
+    unread = std::max(unread, end);
+}
+
+void PinnedGenomes::release(){
+    std::lock_guard<std::mutex> lock(mutex);
+    released = true;
+}
+
+void PinnedGenomes::detach(){
+    std::lock_guard<std::mutex> lock(mutex);
+    if(released || unread==individuals){
+        return;
+    }
+    //Packed, since they're only read from now on
+    uint64_t bytes = length*(individuals - unread);
+    copy = static_cast<uint8_t*>(std::malloc(bytes));
+    assert(copy && "PinnedGenomes: couldn't allocate the copy of the genomes.\n");
+    for(int i=unread;i<individuals;++i){
+        std::memcpy(copy + (i - unread)*length, genomes + (i - first)*step, length);
+    }
+    genomes = copy;
+    first = unread;
+    step = length;
+    INSTRUMENT_COUNT(Allocations, 1);
+    INSTRUMENT_COUNT(AllocatedBytes, bytes);
+}
+
+void Population::prefetch(int i) const{
+    if(!mapping){
+        return;
+    }
+    static const uintptr_t pageSize = uintptr_t(sysconf(_SC_PAGESIZE));
+    uintptr_t first = reinterpret_cast<uintptr_t>(genome(i)) & ~(pageSize - 1);
+    uintptr_t last = reinterpret_cast<uintptr_t>(genome(i)) + length;
+    madvise(reinterpret_cast<void*>(first), last - first, MADV_WILLNEED);
+}
+
+void Population::adviseSequentialWrite(){
+    if(!mapping){
+        return;
+    }
+    madvise(buffers[current ^ 1], arenaLength(genomeStride, individuals), MADV_SEQUENTIAL);
+}
+
+//Packs each pair with the smaller parent in the high bits, so that sorting them groups children of nearby parents, then the other parent and,
+//in the lowest bit, whether the smaller parent was the second winner, so that the parents keep their roles in the crossover
+void schedulePairs(const int *winners, int size, uint64_t *schedule){
+    for(int i=0;i<size;++i){
+        uint32_t a = winners[2*i];
+        uint32_t b = winners[2*i + 1];
+        schedule[i] = a<=b ? (uint64_t(a) << 32) | (b << 1) : (uint64_t(b) << 32) | (a << 1) | 1;
+    }
+    std::sort(schedule, schedule+size);
+}
+
+inline int smallerParent(uint64_t pair){
+    return int(pair >> 32);
+}
+
+inline int largerParent(uint64_t pair){
+    return int(uint32_t(pair) >> 1);
+}
+
+inline int firstParent(uint64_t pair){
+    return pair & 1 ? largerParent(pair) : smallerParent(pair);
+}
+
+inline int secondParent(uint64_t pair){
+    return pair & 1 ? smallerParent(pair) : largerParent(pair);
+}
+
+//Returns the number of children whose fitness memo found in its cache
+int reproduceRange(Population &population, const uint64_t *schedule, int begin, int end, CrossoverKind crossoverKind, float mutationRate, uint64_t *genesLoci, int genesLociLength,
+                   FitnessMemo *memo, float *fitness, RandomEngine &engine){
+    uint64_t length = population.genomeLength();
+    int known = 0;
+    bool prefetching = population.mapped();
+    for(int i=begin;prefetching && i<std::min(begin + prefetchDistance, end);++i){
+        population.prefetch(smallerParent(schedule[i]));
+        population.prefetch(largerParent(schedule[i]));
+    }
+    for(int i=begin;i<end;++i){
+        if(prefetching && i + prefetchDistance<end){
+            //The smaller parents are in order, so most of these are already resident
+            population.prefetch(smallerParent(schedule[i + prefetchDistance]));
+            population.prefetch(largerParent(schedule[i + prefetchDistance]));
+        }
+        uint8_t *parent1 = population.genome(firstParent(schedule[i]));
+        uint8_t *parent2 = population.genome(secondParent(schedule[i]));
+        uint8_t *child = population.nextGenome(i);
+        if(crossoverKind==CrossoverKind::TwoPoints){
+            if(genesLoci){
+                twoPointsCrossover(parent1, parent2, length, child, genesLoci, genesLociLength, engine);
+            } else {
+                twoPointsCrossover(parent1, parent2, length, child, engine);
+            }
+        } else {
+            if(genesLoci){
+                uniformCrossover(parent1, parent2, length, child, genesLoci, genesLociLength, engine);
+            } else {
+                uniformCrossover(parent1, parent2, length, child, engine);
+            }
+        }
+        if(mutationRate>0){
+            if(genesLoci){
+                mutate(child, length, genesLoci, genesLociLength, mutationRate, engine);
+            } else {
+                mutate(child, int(length), mutationRate, engine);
+            }
+        }
+        if(memo){
+            //The child was just written, so it's hashed out of the cache
+            memo->hashes[i] = genomeHash(child, length);
+            memo->known[i] = memo->cache->find(memo->hashes[i], fitness[i]);
+            known += memo->known[i];
+        }
+    }
+    if(memo){
+        INSTRUMENT_COUNT(FitnessHits, known);
+        INSTRUMENT_COUNT(FitnessMisses, end - begin - known);
+    }
+    return known;
+}
+
+int reproduceWithMemo(Population &population, const int *winners, CrossoverKind crossoverKind, float mutationRate, uint64_t *genesLoci, int genesLociLength,
+                      FitnessMemo *memo, float *fitness, RandomEngine &engine){
+    INSTRUMENT_OPERATOR(Reproduce);
+    assert(winners);
+    assert(mutationRate>=0 && mutationRate<1 && "reproduce: mutationRate must be at least 0 and less than 1.\n");
+    uint64_t *schedule = population.schedule.data();
+    schedulePairs(winners, population.size(), schedule);
+    population.adviseSequentialWrite();
+    int known = reproduceRange(population, schedule, 0, population.size(), crossoverKind, mutationRate, genesLoci, genesLociLength, memo, fitness, engine);
+    population.swap();
+    return known;
+}
+
+void reproduce(Population &population, const int *winners, CrossoverKind crossoverKind, float mutationRate, uint64_t *genesLoci, int genesLociLength, RandomEngine &engine){
+    reproduceWithMemo(population, winners, crossoverKind, mutationRate, genesLoci, genesLociLength, NULL, NULL, engine);
+}
+
+int reproduce(Population &population, const int *winners, CrossoverKind crossoverKind, float mutationRate, uint64_t *genesLoci, int genesLociLength, FitnessMemo &memo, float *fitness, RandomEngine &engine){
+    assert(fitness);
+    assert(int(memo.hashes.size())>=population.size() && "reproduce: memo is smaller than the population.\n");
+    return reproduceWithMemo(population, winners, crossoverKind, mutationRate, genesLoci, genesLociLength, &memo, fitness, engine);
+}
+
+void reproduce(Population &population, const int *winners, CrossoverKind crossoverKind, float mutationRate, RandomEngine &engine){
+    reproduce(population, winners, crossoverKind, mutationRate, NULL, 0, engine);
+}
+
+//Whole genomes per chunk, so that a chunk holds about parallelGenomeGrain bytes
+int64_t genomesPerChunk(const Population &population){
+    return std::max<int64_t>(1, parallelGenomeGrain/population.stride());
+}
+
+int reproduceWithMemo(Population &population, const int *winners, CrossoverKind crossoverKind, float mutationRate, uint64_t *genesLoci, int genesLociLength,
+                      FitnessMemo *memo, float *fitness, ThreadPool &pool, RandomEngine &engine){
+    INSTRUMENT_OPERATOR(Reproduce);
+    assert(winners);
+    assert(mutationRate>=0 && mutationRate<1 && "reproduce: mutationRate must be at least 0 and less than 1.\n");
+    uint64_t *schedule = population.schedule.data();
+    schedulePairs(winners, population.size(), schedule);
+    population.adviseSequentialWrite();
+    uint64_t seed = engine();
+    std::atomic<int> known(0);
+    pool.parallelFor(population.size(), genomesPerChunk(population), [&](int64_t chunk, int64_t begin, int64_t end){
+        RandomEngine chunkEngine(seed, chunk);
+        int chunkKnown = reproduceRange(population, schedule, int(begin), int(end), crossoverKind, mutationRate, genesLoci, genesLociLength, memo, fitness, chunkEngine);
+        known.fetch_add(chunkKnown, std::memory_order_relaxed);
+    });
+    population.swap();
+    return known.load(std::memory_order_relaxed);
+}
+
+void reproduce(Population &population, const int *winners, CrossoverKind crossoverKind, float mutationRate, uint64_t *genesLoci, int genesLociLength, ThreadPool &pool, RandomEngine &engine){
+    reproduceWithMemo(population, winners, crossoverKind, mutationRate, genesLoci, genesLociLength, NULL, NULL, pool, engine);
+}
+
+int reproduce(Population &population, const int *winners, CrossoverKind crossoverKind, float mutationRate, uint64_t *genesLoci, int genesLociLength, FitnessMemo &memo, float *fitness,
+              ThreadPool &pool, RandomEngine &engine){
+    assert(fitness);
+    assert(int(memo.hashes.size())>=population.size() && "reproduce: memo is smaller than the population.\n");
+    return reproduceWithMemo(population, winners, crossoverKind, mutationRate, genesLoci, genesLociLength, &memo, fitness, pool, engine);
+}
+
+void reproduce(Population &population, const int *winners, CrossoverKind crossoverKind, float mutationRate, ThreadPool &pool, RandomEngine &engine){
+    reproduce(population, winners, crossoverKind, mutationRate, NULL, 0, pool, engine);
+}
+
+void evaluateFitness(const Population &population, float *fitness, const std::function<float(const uint8_t*, uint64_t)> &evaluate, ThreadPool &pool){
+    INSTRUMENT_OPERATOR(EvaluateFitness);
+    assert(fitness);
+    uint64_t length = population.genomeLength();
+    pool.parallelFor(population.size(), genomesPerChunk(population), [&](int64_t, int64_t begin, int64_t end){
+        for(int64_t i=begin;i<end;++i){
+            fitness[i] = evaluate(population.genome(int(i)), length);
+        }
+    });
+}
+
+int lookupFitness(const Population &population, FitnessMemo &memo, float *fitness, ThreadPool &pool){
+    assert(fitness);
+    assert(int(memo.hashes.size())>=population.size() && "lookupFitness: memo is smaller than the population.\n");
+    uint64_t length = population.genomeLength();
+    std::atomic<int> known(0);
+    pool.parallelFor(population.size(), genomesPerChunk(population), [&](int64_t, int64_t begin, int64_t end){
+        int chunkKnown = 0;
+        for(int64_t i=begin;i<end;++i){
+            memo.hashes[i] = genomeHash(population.genome(int(i)), length);
+            memo.known[i] = memo.cache->find(memo.hashes[i], fitness[i]);
+            chunkKnown += memo.known[i];
+        }
+        INSTRUMENT_COUNT(FitnessHits, chunkKnown);
+        INSTRUMENT_COUNT(FitnessMisses, end - begin - chunkKnown);
+        known.fetch_add(chunkKnown, std::memory_order_relaxed);
+    });
+    return known.load(std::memory_order_relaxed);
+}
+
+int evaluateFitness(const Population &population, float *fitness, const std::function<float(const uint8_t*, uint64_t)> &evaluate, FitnessMemo &memo, ThreadPool &pool){
+    INSTRUMENT_OPERATOR(EvaluateFitness);
+    assert(fitness);
+    assert(int(memo.hashes.size())>=population.size() && "evaluateFitness: memo is smaller than the population.\n");
+    const uint64_t *hashes = memo.hashes.data();
+    int *novel = memo.novel.data();
+    int novelCount = 0;
+    for(int i=0;i<population.size();++i){
+        if(!memo.known[i]){
+            novel[novelCount++] = i;
+        }
+    }
+    //Identical genomes end up next to each other, the first of each run being evaluated for all of them
+    std::sort(novel, novel+novelCount, [hashes](int a, int b){ return hashes[a]<hashes[b] || (hashes[a]==hashes[b] && a<b); });
+    int *distinct = memo.distinct.data();
+    int distinctCount = 0;
+    for(int k=0;k<novelCount;++k){
+        if(!k || hashes[novel[k]]!=hashes[novel[k - 1]]){
+            distinct[distinctCount++] = novel[k];
+        }
+    }
+    uint64_t length = population.genomeLength();
+    FitnessCache &cache = *memo.cache;
+    pool.parallelFor(distinctCount, genomesPerChunk(population), [&](int64_t, int64_t begin, int64_t end){
+        for(int64_t k=begin;k<end;++k){
+            int i = distinct[k];
+            fitness[i] = evaluate(population.genome(i), length);
+            cache.insert(hashes[i], fitness[i]);
+        }
+    });
+    for(int k=0;k<novelCount;++k){
+        if(k && hashes[novel[k]]==hashes[novel[k - 1]]){
+            fitness[novel[k]] = fitness[novel[k - 1]];
+        }
+        memo.known[novel[k]] = 1;
+    }
+    return distinctCount;
+}
@@ -0,0 +1,54 @@
+#include <random>
+#include <random-engine.hpp>
+
+RandomEngine::RandomEngine(){
+    std::random_device rd;
+    seed((uint64_t(rd()) << 32) | rd());
+}
+
+//The splitmix64 finalizer
+uint64_t mix64(uint64_t z){
+    z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27))*0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+RandomEngine::RandomEngine(uint64_t seed){
+    this->seed(seed);
+}
+
+RandomEngine::RandomEngine(uint64_t seed, uint64_t stream){
+    this->seed(mix64(seed ^ mix64(stream + 0x9e3779b97f4a7c15)));
+}
+
+void RandomEngine::seed(uint64_t seed){
+    //splitmix64, as recommended by the xoshiro authors, so that even seeds with few bits set give a well mixed state
+    for(int i=0;i<4;++i){
+        state[i] = mix64(seed += 0x9e3779b97f4a7c15);
+    }
+}
+
+void RandomEngine::jump(){
+    static const uint64_t jumpPolynomial[] = {0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c};
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for(int i=0;i<4;++i){
+        for(int b=0;b<64;++b){
+            if(jumpPolynomial[i] & (uint64_t(1) << b)){
+                s0 ^= state[0];
+                s1 ^= state[1];
+                s2 ^= state[2];
+                s3 ^= state[3];
+            }
+            operator()();
+        }
+    }
+    state[0] = s0;
+    state[1] = s1;
+    state[2] = s2;
+    state[3] = s3;
+}
+
+RandomEngine& defaultRandomEngine(){
+    thread_local RandomEngine engine;
+    return engine;
+}
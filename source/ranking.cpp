@@ -0,0 +1,123 @@
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <ranking.hpp>
+#include <thread-pool.hpp>
+#include "instrumentation-hooks.hpp"
+
+//The radix sort goes through the 32 bits of the keys in 3 passes
+const int radixBits     = 11;
+const int radixBuckets  = 1 << radixBits;
+const int radixPasses   = 3;
+
+uint64_t rankingKey(float fitness, int index, bool maximizeFitness){
+    //Maps fitness to a uint32 that sorts in the same order, with the best individual first
+    uint32_t bits;
+    std::memcpy(&bits, &fitness, sizeof(bits));
+    bits ^= (bits >> 31) ? 0xffffffffu : 0x80000000u;
+    if(maximizeFitness){
+        bits = ~bits;
+    }
+    return (uint64_t(bits) << 32) | uint32_t(index);
+}
+
+void packRankingKeys(const float *fitness, int begin, int end, bool maximizeFitness, uint64_t *packed){
+    for(int i=begin;i<end;++i){
+        packed[i] = rankingKey(fitness[i], i, maximizeFitness);
+    }
+}
+
+void radixSortKeys(uint64_t *packed, uint64_t *swap, int size){
+    //All the histograms are built in a single pass over the keys
+    uint32_t histograms[radixPasses][radixBuckets] = {};
+    for(int i=0;i<size;++i){
+        uint32_t key = uint32_t(packed[i] >> 32);
+        for(int pass=0;pass<radixPasses;++pass){
+            histograms[pass][(key >> (pass*radixBits)) & (radixBuckets - 1)]++;
+        }
+    }
+    uint64_t *source = packed;
+    uint64_t *destination = swap;
+    for(int pass=0;pass<radixPasses;++pass){
+        uint32_t *histogram = histograms[pass];
+        int shift = 32 + pass*radixBits;
+        //A pass in which every key falls in the same bucket wouldn't move anything
+        if(histogram[(source[0] >> shift) & (radixBuckets - 1)]==uint32_t(size)){
+            continue;
+        }
+        uint32_t offset = 0;
+        for(int b=0;b<radixBuckets;++b){
+            uint32_t count = histogram[b];
+            histogram[b] = offset;
+            offset += count;
+        }
+        for(int i=0;i<size;++i){
+            destination[histogram[(source[i] >> shift) & (radixBuckets - 1)]++] = source[i];
+        }
+        std::swap(source, destination);
+    }
+    if(source!=packed){
+        std::memcpy(packed, source, size*sizeof(uint64_t));
+    }
+}
+
+void sortRun(uint64_t *packed, uint64_t *swap, int size){
+    if(size<radixRankingThreshold){
+        std::sort(packed, packed+size);
+    } else {
+        radixSortKeys(packed, swap, size);
+    }
+}
+
+void rankPopulation(const float *fitness, int populationSize, bool maximizeFitness, int *ranksLookup, SelectionWorkspace &workspace){
+    INSTRUMENT_OPERATOR(RankPopulation);
+    assert(populationSize>0 && "rankPopulation: populationSize must be positive.\n");
+    assert(ranksLookup);
+    uint64_t *packed = workspace.scratch(workspace.sortKeys, populationSize);
+    packRankingKeys(fitness, 0, populationSize, maximizeFitness, packed);
+    sortRun(packed, workspace.scratch(workspace.sortKeysSwap, populationSize), populationSize);
+    for(int i=0;i<populationSize;++i){
+        ranksLookup[i] = int(uint32_t(packed[i]));
+    }
+}
+
+void rankPopulation(const float *fitness, int populationSize, bool maximizeFitness, int *ranksLookup, SelectionWorkspace &workspace, ThreadPool &pool){
+    INSTRUMENT_OPERATOR(RankPopulation);
+    assert(populationSize>0 && "rankPopulation: populationSize must be positive.\n");
+    assert(ranksLookup);
+    uint64_t *packed = workspace.scratch(workspace.sortKeys, populationSize);
+    uint64_t *swap = workspace.scratch(workspace.sortKeysSwap, populationSize);
+    int64_t run = std::max<int64_t>(radixRankingThreshold, (populationSize + pool.size() - 1)/pool.size());
+    pool.parallelFor(populationSize, run, [&](int64_t, int64_t begin, int64_t end){
+        packRankingKeys(fitness, int(begin), int(end), maximizeFitness, packed);
+        sortRun(packed + begin, swap + begin, int(end - begin));
+    });
+    for(int64_t width=run;width<populationSize;width*=2){
+        pool.parallelFor(populationSize, 2*width, [&](int64_t, int64_t begin, int64_t end){
+            int64_t middle = std::min(begin + width, end);
+            std::merge(packed + begin, packed + middle, packed + middle, packed + end, swap + begin);
+        });
+        std::swap(packed, swap);
+    }
+    pool.parallelFor(populationSize, run, [&](int64_t, int64_t begin, int64_t end){
+        for(int64_t i=begin;i<end;++i){
+            ranksLookup[i] = int(uint32_t(packed[i]));
+        }
+    });
+}
+
+void partialRankPopulation(const float *fitness, int populationSize, bool maximizeFitness, int count, int *ranksLookup, SelectionWorkspace &workspace){
+    INSTRUMENT_OPERATOR(RankPopulation);
+    assert(populationSize>0 && "partialRankPopulation: populationSize must be positive.\n");
+    assert(count>=0 && count<=populationSize && "partialRankPopulation: count must be between 0 and populationSize.\n");
+    assert(ranksLookup);
+    uint64_t *packed = workspace.scratch(workspace.sortKeys, populationSize);
+    packRankingKeys(fitness, 0, populationSize, maximizeFitness, packed);
+    if(count<populationSize){
+        std::nth_element(packed, packed+count, packed+populationSize);
+    }
+    std::sort(packed, packed+count);
+    for(int i=0;i<count;++i){
+        ranksLookup[i] = int(uint32_t(packed[i]));
+    }
+}
@@ -0,0 +1,257 @@
+#include <cassert>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <real-operators.hpp>
+
+//How many random numbers are drawn at once, so that the loops consuming them have no calls to the engine in them
+const uint64_t randomBlock = 64;
+
+//How many Reals a random word yields, and how
+template<typename Real> struct RealBits;
+
+template<> struct RealBits<float>{
+    static const uint64_t perWord = 2;
+    static float convert(uint64_t word, uint64_t half){
+        return float((word >> (32*half + 8)) & 0xFFFFFF)*(1.f/16777216.f);
+    }
+};
+
+template<> struct RealBits<double>{
+    static const uint64_t perWord = 1;
+    static double convert(uint64_t word, uint64_t){
+        return double(word >> 11)*(1./9007199254740992.);
+    }
+};
+
+template<typename Real>
+void uniformReals(RandomEngine &engine, Real *values, uint64_t count){
+    const uint64_t perWord = RealBits<Real>::perWord;
+    uint64_t words[randomBlock];
+    while(count){
+        uint64_t n = std::min(count, randomBlock*perWord);
+        uint64_t wordsCount = (n + perWord - 1)/perWord;
+        for(uint64_t w=0;w<wordsCount;++w){
+            words[w] = engine();
+        }
+        for(uint64_t i=0;i<n;++i){
+            values[i] = RealBits<Real>::convert(words[i/perWord], i%perWord);
+        }
+        values += n;
+        count -= n;
+    }
+}
+
+template<typename Real>
+void normalReals(RandomEngine &engine, Real *values, uint64_t count){
+    const Real twoPi = Real(6.283185307179586);
+    Real uniforms[2*randomBlock];
+    while(count){
+        uint64_t n = std::min(count, 2*randomBlock);
+        //Each pair of uniforms makes a pair of normals, the first halves go to values[0, pairs), the second ones after
+        uint64_t pairs = (n + 1)/2;
+        uniformReals(engine, uniforms, 2*pairs);
+        for(uint64_t k=0;k<pairs;++k){
+            Real radius = std::sqrt(Real(-2)*std::log(Real(1) - uniforms[k]));
+            Real angle = twoPi*uniforms[pairs + k];
+            values[k] = radius*std::cos(angle);
+            if(pairs + k<n){
+                values[pairs + k] = radius*std::sin(angle);
+            }
+        }
+        values += n;
+        count -= n;
+    }
+}
+
+template<typename Real>
+void clampToBounds(Real *genes, uint64_t count, const Real *lowerBounds, const Real *upperBounds){
+    if(lowerBounds){
+        for(uint64_t i=0;i<count;++i){
+            genes[i] = genes[i]<lowerBounds[i] ? lowerBounds[i] : genes[i];
+        }
+    }
+    if(upperBounds){
+        for(uint64_t i=0;i<count;++i){
+            genes[i] = genes[i]>upperBounds[i] ? upperBounds[i] : genes[i];
+        }
+    }
+}
+
+template<typename Real>
+void arithmeticCrossover(const Real *parent1, const Real *parent2, uint64_t genes, Real *child, RandomEngine &engine){
+    assert(child);
+    Real weight;
+    uniformReals(engine, &weight, 1);
+    for(uint64_t i=0;i<genes;++i){
+        child[i] = parent2[i] + weight*(parent1[i] - parent2[i]);
+    }
+}
+
+template<typename Real>
+void blendCrossover(const Real *parent1, const Real *parent2, uint64_t genes, Real *child, float alpha, const Real *lowerBounds, const Real *upperBounds, RandomEngine &engine){
+    assert(child);
+    assert(alpha>=0 && "blendCrossover: alpha must be non-negative.\n");
+    const Real widening = Real(alpha);
+    Real uniforms[randomBlock];
+    for(uint64_t begin=0;begin<genes;begin+=randomBlock){
+        uint64_t n = std::min(genes - begin, randomBlock);
+        uniformReals(engine, uniforms, n);
+        for(uint64_t i=0;i<n;++i){
+            Real low = std::min(parent1[begin + i], parent2[begin + i]);
+            Real width = std::max(parent1[begin + i], parent2[begin + i]) - low;
+            child[begin + i] = low - widening*width + uniforms[i]*(width + 2*widening*width);
+        }
+    }
+    clampToBounds(child, genes, lowerBounds, upperBounds);
+}
+
+template<typename Real>
+void simulatedBinaryCrossover(const Real *parent1, const Real *parent2, uint64_t genes, Real *child, float distributionIndex, const Real *lowerBounds, const Real *upperBounds, RandomEngine &engine){
+    assert(child);
+    assert(distributionIndex>=0 && "simulatedBinaryCrossover: distributionIndex must be non-negative.\n");
+    const Real exponent = Real(1)/(Real(distributionIndex) + Real(1));
+    Real uniforms[randomBlock];
+    for(uint64_t begin=0;begin<genes;begin+=randomBlock){
+        uint64_t n = std::min(genes - begin, randomBlock);
+        uniformReals(engine, uniforms, n);
+        //Which of the two offspring each gene comes from
+        uint64_t sides = engine();
+        for(uint64_t i=0;i<n;++i){
+            Real u = uniforms[i];
+            Real spread = u<=Real(0.5) ? std::pow(2*u, exponent) : std::pow(Real(1)/(2*(Real(1) - u)), exponent);
+            Real mean = (parent1[begin + i] + parent2[begin + i])*Real(0.5);
+            Real offset = spread*(parent1[begin + i] - parent2[begin + i])*Real(0.5);
+            child[begin + i] = ((sides >> i) & 1) ? mean + offset : mean - offset;
+        }
+    }
+    clampToBounds(child, genes, lowerBounds, upperBounds);
+}
+
+template<typename Real>
+void gaussianMutate(Real *individual, uint64_t genes, float mutationProbability, float sigma, const Real *lowerBounds, const Real *upperBounds, RandomEngine &engine){
+    assert(mutationProbability>=0 && mutationProbability<=1 && "gaussianMutate: mutationProbability must be between 0 and 1.\n");
+    uint64_t positions[randomBlock];
+    Real noise[randomBlock];
+    uint64_t pending = 0;
+    auto flush = [&](){
+        normalReals(engine, noise, pending);
+        for(uint64_t k=0;k<pending;++k){
+            uint64_t g = positions[k];
+            Real value = individual[g] + Real(sigma)*noise[k];
+            value = lowerBounds && value<lowerBounds[g] ? lowerBounds[g] : value;
+            value = upperBounds && value>upperBounds[g] ? upperBounds[g] : value;
+            individual[g] = value;
+        }
+        pending = 0;
+    };
+    GeometricSkip skip(mutationProbability);
+    for(uint64_t g=skip.next(engine, genes);g<genes;g+=1 + skip.next(engine, genes)){
+        positions[pending++] = g;
+        if(pending==randomBlock){
+            flush();
+        }
+    }
+    flush();
+}
+
+template<typename Real>
+void polynomialMutate(Real *individual, uint64_t genes, float mutationProbability, float distributionIndex, const Real *lowerBounds, const Real *upperBounds, RandomEngine &engine){
+    assert(mutationProbability>=0 && mutationProbability<=1 && "polynomialMutate: mutationProbability must be between 0 and 1.\n");
+    assert(lowerBounds && upperBounds && "polynomialMutate: the bounds are required.\n");
+    const Real power = Real(distributionIndex) + Real(1);
+    const Real exponent = Real(1)/power;
+    uint64_t positions[randomBlock];
+    Real uniforms[randomBlock];
+    uint64_t pending = 0;
+    auto flush = [&](){
+        uniformReals(engine, uniforms, pending);
+        for(uint64_t k=0;k<pending;++k){
+            uint64_t g = positions[k];
+            Real range = upperBounds[g] - lowerBounds[g];
+            if(!(range>0)){
+                continue;
+            }
+            Real value = individual[g];
+            Real u = uniforms[k];
+            Real delta;
+            if(u<Real(0.5)){
+                Real complement = Real(1) - (value - lowerBounds[g])/range;
+                delta = std::pow(2*u + (Real(1) - 2*u)*std::pow(complement, power), exponent) - Real(1);
+            } else {
+                Real complement = Real(1) - (upperBounds[g] - value)/range;
+                delta = Real(1) - std::pow(2*(Real(1) - u) + 2*(u - Real(0.5))*std::pow(complement, power), exponent);
+            }
+            value += delta*range;
+            value = value<lowerBounds[g] ? lowerBounds[g] : value;
+            value = value>upperBounds[g] ? upperBounds[g] : value;
+            individual[g] = value;
+        }
+        pending = 0;
+    };
+    GeometricSkip skip(mutationProbability);
+    for(uint64_t g=skip.next(engine, genes);g<genes;g+=1 + skip.next(engine, genes)){
+        positions[pending++] = g;
+        if(pending==randomBlock){
+            flush();
+        }
+    }
+    flush();
+}
+
+template<typename Real>
+void arithmeticCrossover(const Real *parents, const int *pairs, int offspringCount, uint64_t genes, uint64_t stride, Real *offspring, RandomEngine &engine){
+    assert(pairs && offspring);
+    for(int i=0;i<offspringCount;++i){
+        arithmeticCrossover(parents + pairs[2*i]*stride, parents + pairs[2*i + 1]*stride, genes, offspring + i*stride, engine);
+    }
+}
+
+template<typename Real>
+void blendCrossover(const Real *parents, const int *pairs, int offspringCount, uint64_t genes, uint64_t stride, Real *offspring, float alpha, const Real *lowerBounds, const Real *upperBounds, RandomEngine &engine){
+    assert(pairs && offspring);
+    for(int i=0;i<offspringCount;++i){
+        blendCrossover(parents + pairs[2*i]*stride, parents + pairs[2*i + 1]*stride, genes, offspring + i*stride, alpha, lowerBounds, upperBounds, engine);
+    }
+}
+
+template<typename Real>
+void simulatedBinaryCrossover(const Real *parents, const int *pairs, int offspringCount, uint64_t genes, uint64_t stride, Real *offspring, float distributionIndex, const Real *lowerBounds, const Real *upperBounds, RandomEngine &engine){
+    assert(pairs && offspring);
+    for(int i=0;i<offspringCount;++i){
+        simulatedBinaryCrossover(parents + pairs[2*i]*stride, parents + pairs[2*i + 1]*stride, genes, offspring + i*stride, distributionIndex, lowerBounds, upperBounds, engine);
+    }
+}
+
+template<typename Real>
+void gaussianMutate(Real *individuals, int count, uint64_t genes, uint64_t stride, float mutationProbability, float sigma, const Real *lowerBounds, const Real *upperBounds, RandomEngine &engine){
+    for(int i=0;i<count;++i){
+        gaussianMutate(individuals + i*stride, genes, mutationProbability, sigma, lowerBounds, upperBounds, engine);
+    }
+}
+
+template<typename Real>
+void polynomialMutate(Real *individuals, int count, uint64_t genes, uint64_t stride, float mutationProbability, float distributionIndex, const Real *lowerBounds, const Real *upperBounds, RandomEngine &engine){
+    for(int i=0;i<count;++i){
+        polynomialMutate(individuals + i*stride, genes, mutationProbability, distributionIndex, lowerBounds, upperBounds, engine);
+    }
+}
+
+#define INSTANTIATE_REAL_OPERATORS(Real) \
+    template void uniformReals<Real>(RandomEngine&, Real*, uint64_t); \
+    template void normalReals<Real>(RandomEngine&, Real*, uint64_t); \
+    template void arithmeticCrossover<Real>(const Real*, const Real*, uint64_t, Real*, RandomEngine&); \
+    template void blendCrossover<Real>(const Real*, const Real*, uint64_t, Real*, float, const Real*, const Real*, RandomEngine&); \
+    template void simulatedBinaryCrossover<Real>(const Real*, const Real*, uint64_t, Real*, float, const Real*, const Real*, RandomEngine&); \
+    template void gaussianMutate<Real>(Real*, uint64_t, float, float, const Real*, const Real*, RandomEngine&); \
+    template void polynomialMutate<Real>(Real*, uint64_t, float, float, const Real*, const Real*, RandomEngine&); \
+    template void arithmeticCrossover<Real>(const Real*, const int*, int, uint64_t, uint64_t, Real*, RandomEngine&); \
+    template void blendCrossover<Real>(const Real*, const int*, int, uint64_t, uint64_t, Real*, float, const Real*, const Real*, RandomEngine&); \
+    template void simulatedBinaryCrossover<Real>(const Real*, const int*, int, uint64_t, uint64_t, Real*, float, const Real*, const Real*, RandomEngine&); \
+    template void gaussianMutate<Real>(Real*, int, uint64_t, uint64_t, float, float, const Real*, const Real*, RandomEngine&); \
+    template void polynomialMutate<Real>(Real*, int, uint64_t, uint64_t, float, float, const Real*, const Real*, RandomEngine&);
+
+INSTANTIATE_REAL_OPERATORS(float)
+INSTANTIATE_REAL_OPERATORS(double)
+
+#undef INSTANTIATE_REAL_OPERATORS
@@ -0,0 +1,113 @@
+#include <cassert>
+#include <algorithm>
+#include <cmath>
+#include <selection-distribution.hpp>
+
+//Roughly how many binary search steps building an alias table costs per individual
+const float aliasBuildCost = 4.f;
+
+int SelectionDistribution::sampleCumulative(double u) const{
+    double pick = u*cumulativeProbabilities[size-1];
+    int index = std::upper_bound(cumulativeProbabilities.begin(), cumulativeProbabilities.begin()+size, pick) - cumulativeProbabilities.begin();
+    //pick can round up to the total weight
+    return index<size ? index : size-1;
+}
+
+SamplingMethod resolveSamplingMethod(SamplingMethod method, int populationSize, int winnersSize){
+    if(method!=SamplingMethod::Automatic){
+        return method;
+    }
+    float searchCost = float(winnersSize)*std::log2(float(populationSize) + 1.f);
+    return searchCost > aliasBuildCost*float(populationSize) ? SamplingMethod::Alias : SamplingMethod::BinarySearch;
+}
+
+void buildSelectionDistribution(const float *cumulativeWeights, int size, SamplingMethod method, SelectionDistribution &distribution){
+    assert(size>0 && "buildSelectionDistribution: size must be positive.\n");
+    assert(method!=SamplingMethod::Automatic && "buildSelectionDistribution: resolve the method with resolveSamplingMethod first.\n");
+    assert(cumulativeWeights[size-1]>0 && "buildSelectionDistribution: the total weight must be positive.\n");
+    distribution.method = method;
+    distribution.size = size;
+    if(method==SamplingMethod::BinarySearch || method==SamplingMethod::Universal){
+        distribution.cumulativeProbabilities.assign(cumulativeWeights, cumulativeWeights+size);
+        return;
+    }
+    //Vose's method: small columns are pushed from the front of worklist, large ones from the back
+    distribution.thresholds.resize(size);
+    distribution.aliases.resize(size);
+    distribution.worklist.resize(size);
+    float *thresholds = distribution.thresholds.data();
+    int *aliases = distribution.aliases.data();
+    int *worklist = distribution.worklist.data();
+    double scale = double(size)/cumulativeWeights[size-1];
+    int smallCount = 0;
+    int largeStart = size;
+    float previous = 0;
+    for(int i=0;i<size;++i){
+        thresholds[i] = float((cumulativeWeights[i] - previous)*scale);
+        previous = cumulativeWeights[i];
+        aliases[i] = i;
+        if(thresholds[i]<1.f){
+            worklist[smallCount++] = i;
+        } else {
+            worklist[--largeStart] = i;
+        }
+    }
+    int largeEnd = size;
+    while(smallCount && largeStart<largeEnd){
+        int small = worklist[--smallCount];
+        int large = worklist[largeStart];
+        aliases[small] = large;
+        thresholds[large] -= 1.f - thresholds[small];
+        if(thresholds[large]<1.f){
+            //The small stack can't reach largeStart, as it holds at most size - (largeEnd - largeStart) entries
+            ++largeStart;
+            worklist[smallCount++] = large;
+        }
+    }
+    //Whatever is left differs from 1 only because of rounding
+    for(int i=0;i<smallCount;++i){
+        thresholds[worklist[i]] = 1.f;
+    }
+    for(int i=largeStart;i<largeEnd;++i){
+        thresholds[worklist[i]] = 1.f;
+    }
+}
+
+void sampleUniversal(const SelectionDistribution &distribution, double offset, int first, int count, int winnersSize, int *winners){
+    assert(distribution.method!=SamplingMethod::Alias && "sampleUniversal: the distribution needs its cumulative probabilities.\n");
+    assert(count>=0 && first>=0 && first + count<=winnersSize && "sampleUniversal: the pointers must be in [0, winnersSize).\n");
+    if(!count){
+        return;
+    }
+    const float *cumulative = distribution.cumulativeProbabilities.data();
+    double spacing = double(cumulative[distribution.size-1])/winnersSize;
+    //Only the first pointer is searched for, the others are found by walking forward from it
+    int index = std::upper_bound(cumulative, cumulative+distribution.size, (offset + first)*spacing) - cumulative;
+    index = std::min(index, distribution.size-1);
+    for(int k=0;k<count;++k){
+        double pointer = (offset + first + k)*spacing;
+        while(index<distribution.size-1 && cumulative[index]<=pointer){
+            ++index;
+        }
+        winners[k] = index;
+    }
+}
+
+void shuffleWinners(int *winners, int winnersSize, RandomEngine &engine){
+    assert(winners || !winnersSize);
+    for(int i=winnersSize-1;i>0;--i){
+        std::swap(winners[i], winners[engine.bounded(uint32_t(i + 1))]);
+    }
+}
+
+void sampleSelectionDistribution(const SelectionDistribution &distribution, int *winners, int winnersSize, RandomEngine &engine){
+    assert(winners);
+    if(distribution.method==SamplingMethod::Universal){
+        sampleUniversal(distribution, engine.uniformDouble(), 0, winnersSize, winnersSize, winners);
+        shuffleWinners(winners, winnersSize, engine);
+        return;
+    }
+    for(int i=0;i<winnersSize;++i){
+        winners[i] = distribution.sample(engine);
+    }
+}
@@ -0,0 +1,88 @@
+#include <cassert>
+#include <cstring>
+#include <selection-table-cache.hpp>
+#include "instrumentation-hooks.hpp"
+
+size_t SelectionTableCache::KeyHash::operator()(const SelectionTableKey &key) const{
+    uint32_t parameterBits;
+    std::memcpy(&parameterBits, &key.parameter, sizeof(parameterBits));
+    uint64_t h = (uint64_t(parameterBits) << 32) | uint32_t(key.populationSize);
+    h ^= (uint64_t(key.scheme) << 8 | uint64_t(key.method))*0x9e3779b97f4a7c15;
+    h = (h ^ (h >> 31))*0xbf58476d1ce4e5b9;
+    return size_t(h ^ (h >> 29));
+}
+
+SelectionTableCache::SelectionTableCache(int capacity) : maxSize(capacity){
+    assert(capacity>0 && "SelectionTableCache: capacity must be positive.\n");
+    index.reserve(capacity);
+}
+
+SelectionTableCache::Table SelectionTableCache::fetch(const SelectionTableKey &key, const std::function<void(SelectionDistribution&)> &build){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = index.find(key);
+        if(found!=index.end()){
+            entries.splice(entries.begin(), entries, found->second);
+            hitCount.fetch_add(1, std::memory_order_relaxed);
+            INSTRUMENT_COUNT(TableHits, 1);
+            return found->second->second;
+        }
+    }
+    missCount.fetch_add(1, std::memory_order_relaxed);
+    INSTRUMENT_COUNT(TableMisses, 1);
+    std::shared_ptr<SelectionDistribution> table = std::make_shared<SelectionDistribution>();
+    build(*table);
+    //The alias table's worklist is only needed while building
+    std::vector<int>().swap(table->worklist);
+    INSTRUMENT_COUNT(Allocations, 1);
+    INSTRUMENT_COUNT(AllocatedBytes, sizeof(SelectionDistribution) + table->cumulativeProbabilities.capacity()*sizeof(float) +
+                     table->thresholds.capacity()*sizeof(table->thresholds[0]) + table->aliases.capacity()*sizeof(table->aliases[0]));
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = index.find(key);
+    if(found!=index.end()){
+        //Another thread built it in the meantime, keep a single copy
+        entries.splice(entries.begin(), entries, found->second);
+        return found->second->second;
+    }
+    entries.emplace_front(key, table);
+    index[key] = entries.begin();
+    evict();
+    return table;
+}
+
+void SelectionTableCache::evict(){
+    while(int(entries.size())>maxSize){
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+}
+
+void SelectionTableCache::setCapacity(int capacity){
+    assert(capacity>0 && "SelectionTableCache::setCapacity: capacity must be positive.\n");
+    std::lock_guard<std::mutex> lock(mutex);
+    maxSize = capacity;
+    evict();
+}
+
+int SelectionTableCache::capacity() const{
+    std::lock_guard<std::mutex> lock(mutex);
+    return maxSize;
+}
+
+int SelectionTableCache::size() const{
+    std::lock_guard<std::mutex> lock(mutex);
+    return int(entries.size());
+}
+
+void SelectionTableCache::clear(){
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    index.clear();
+    hitCount.store(0, std::memory_order_relaxed);
+    missCount.store(0, std::memory_order_relaxed);
+}
+
+SelectionTableCache& selectionTableCache(){
+    static SelectionTableCache cache;
+    return cache;
+}
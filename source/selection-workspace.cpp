@@ -0,0 +1,34 @@
+#include <selection-workspace.hpp>
+#include "instrumentation-hooks.hpp"
+
+SelectionWorkspace::SelectionWorkspace(int maxPopulationSize){
+    reserve(maxPopulationSize);
+}
+
+void SelectionWorkspace::reserve(int populationSize){
+    if(populationSize<=maxPopulationSize){
+        return;
+    }
+    maxPopulationSize = populationSize;
+    scratch(weights, populationSize);
+    scratch(sortKeys, populationSize);
+    scratch(sortKeysSwap, populationSize);
+    scratch(ranksLookup, populationSize);
+    scratch(ranks, populationSize);
+    scratch(distribution.cumulativeProbabilities, populationSize);
+    scratch(distribution.thresholds, populationSize);
+    scratch(distribution.aliases, populationSize);
+    scratch(distribution.worklist, populationSize);
+}
+
+//Out of line so that the header doesn't depend on whether instrumentation is compiled in
+void SelectionWorkspace::grew(uint64_t bytes){
+    allocatedBytes += bytes;
+    INSTRUMENT_COUNT(Allocations, 1);
+    INSTRUMENT_COUNT(AllocatedBytes, bytes);
+}
+
+SelectionWorkspace& defaultSelectionWorkspace(){
+    thread_local SelectionWorkspace workspace;
+    return workspace;
+}
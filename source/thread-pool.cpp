@@ -0,0 +1,113 @@
+#include <cassert>
+#include <algorithm>
+#include <thread-pool.hpp>
+
+ThreadPool::ThreadPool(int threads){
+    if(threads<=0){
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for(int i=0;i<threads;++i){
+        queues.emplace_back(new Queue);
+    }
+    for(int i=0;i<threads-1;++i){
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for(std::thread &worker : workers){
+        worker.join();
+    }
+}
+
+bool ThreadPool::takeChunk(int self, int64_t &chunk){
+    int participants = size();
+    for(int i=0;i<participants;++i){
+        Queue &queue = *queues[(self + i)%participants];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(queue.head<queue.tail){
+            //The owner works back to front and thieves front to back, so they only meet on the last chunk
+            chunk = i ? queue.chunks[queue.head++] : queue.chunks[--queue.tail];
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::work(int self){
+    int64_t chunk;
+    while(takeChunk(self, chunk)){
+        int64_t begin = chunk*grain;
+        (*body)(chunk, begin, std::min(begin + grain, count));
+        if(remaining.fetch_sub(1, std::memory_order_acq_rel)==1){
+            std::lock_guard<std::mutex> lock(mutex);
+            done.notify_all();
+        }
+    }
+}
+
+void ThreadPool::workerLoop(int self){
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while(true){
+        wake.wait(lock, [&]{ return stopping || generation!=seen; });
+        if(stopping){
+            return;
+        }
+        seen = generation;
+        ++busy;
+        lock.unlock();
+        work(self);
+        lock.lock();
+        if(--busy==0){
+            done.notify_all();
+        }
+    }
+}
+
+void ThreadPool::parallelFor(int64_t count, int64_t grain, const std::function<void(int64_t, int64_t, int64_t)> &body){
+    assert(grain>0 && "ThreadPool::parallelFor: grain must be positive.\n");
+    if(count<=0){
+        return;
+    }
+    int64_t chunks = (count + grain - 1)/grain;
+    int participants = size();
+    if(chunks==1 || participants==1){
+        for(int64_t chunk=0;chunk<chunks;++chunk){
+            int64_t begin = chunk*grain;
+            body(chunk, begin, std::min(begin + grain, count));
+        }
+        return;
+    }
+    this->body = &body;
+    this->count = count;
+    this->grain = grain;
+    remaining.store(chunks, std::memory_order_relaxed);
+    //Contiguous shares keep neighbouring chunks on the same thread unless they get stolen
+    for(int p=0;p<participants;++p){
+        Queue &queue = *queues[p];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        int64_t first = chunks*p/participants;
+        int64_t last = chunks*(p + 1)/participants;
+        queue.chunks.resize(last - first);
+        for(int64_t chunk=first;chunk<last;++chunk){
+            //The owner takes from the back
+            queue.chunks[last - 1 - chunk] = chunk;
+        }
+        queue.head = 0;
+        queue.tail = last - first;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++generation;
+    }
+    wake.notify_all();
+    work(participants - 1);
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&]{ return busy==0 && remaining.load(std::memory_order_acquire)==0; });
+}
@@ -0,0 +1,23 @@
+#pragma once
+///@file check.hpp
+///@brief The checks the tests are written with: a failed check is reported and fails the test, but the test goes on
+#include <cstdio>
+
+inline int& checkFailures(){
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition) \
+    ((condition) ? (void)0 : (std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition), ++checkFailures(), (void)0))
+
+/*!
+ * @brief What main returns: 0 if every check passed, 1 otherwise
+ */
+inline int checkResult(){
+    if(checkFailures()){
+        std::fprintf(stderr, "%d checks failed\n", checkFailures());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,175 @@
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+#include <checkpoint.hpp>
+#include <parallel-generation.hpp>
+#include "check.hpp"
+
+float countMaskedBits(const uint8_t *genome, uint64_t length){
+    float bits = 0;
+    for(uint64_t i=0;i<length;++i){
+        bits += float(__builtin_popcount(genome[i] & 0x5a));
+    }
+    return bits;
+}
+
+//A generational loop with a fitness memo and two engines, one of them the default engine
+struct Run{
+    int populationSize;
+    uint64_t genomeLength;
+    Population population;
+    FitnessCache cache;
+    FitnessMemo memo;
+    std::vector<float> fitness;
+    std::vector<int> winners;
+    SelectionWorkspace workspace;
+    RandomEngine engine;
+    GenerationState state;
+
+    Run(int populationSize, uint64_t genomeLength) : populationSize(populationSize), genomeLength(genomeLength), population(populationSize, genomeLength), cache(1 << 14), memo(cache, populationSize),
+                                                      fitness(populationSize), winners(2*populationSize), workspace(populationSize), engine(15){
+        state.population = &population;
+        state.fitness = fitness.data();
+        state.engines = {&engine, &defaultRandomEngine()};
+        state.cache = &cache;
+    }
+
+    void randomize(RandomEngine &fill){
+        for(int i=0;i<populationSize;++i){
+            for(uint64_t j=0;j<genomeLength;++j){
+                population.genome(i)[j] = uint8_t(fill());
+            }
+        }
+    }
+
+    void nextGeneration(ThreadPool &pool){
+        tournamentRanking(populationSize, fitness.data(), true, 3, winners.data(), 2*populationSize, workspace, engine);
+        defaultRandomEngine()();
+        reproduce(population, winners.data(), CrossoverKind::Uniform, 0.002f, nullptr, 0, memo, fitness.data(), pool, engine);
+        evaluateFitness(population, fitness.data(), countMaskedBits, memo, pool);
+        ++state.generation;
+    }
+
+    //Folds in everything the next generations depend on
+    uint64_t digest(){
+        uint64_t digest = 0;
+        for(int i=0;i<populationSize;++i){
+            uint32_t bits;
+            std::memcpy(&bits, &fitness[i], sizeof(bits));
+            digest = (digest*31 + genomeHash(population.genome(i), genomeLength))*31 + bits;
+        }
+        return digest*31 + engine() + defaultRandomEngine()();
+    }
+};
+
+//A run resumed from a checkpoint written in the background makes the same generations as the run that wrote it
+void checkResume(const std::string &path){
+    const int populationSize = 3000;
+    const uint64_t genomeLength = 500;
+    ThreadPool pool(3);
+    Run original(populationSize, genomeLength);
+    RandomEngine fill(16);
+    original.randomize(fill);
+    defaultRandomEngine().seed(17);
+    lookupFitness(original.population, original.memo, original.fitness.data(), pool);
+    evaluateFitness(original.population, original.fitness.data(), countMaskedBits, original.memo, pool);
+    CheckpointWriter writer;
+    for(int generation=0;generation<10;++generation){
+        if(generation==4){
+            writer.write(path, original.state);
+        }
+        original.nextGeneration(pool);
+    }
+    writer.wait();
+    uint64_t expected = original.digest();
+    Run resumed(populationSize, genomeLength);
+    defaultRandomEngine().seed(18);
+    loadCheckpoint(path, resumed.state);
+    CHECK(resumed.state.generation==4);
+    while(resumed.state.generation<10){
+        resumed.nextGeneration(pool);
+    }
+    CHECK(resumed.digest()==expected);
+    std::remove(path.c_str());
+}
+
+//The genomes written are the ones pinned, even when both arenas are overwritten before the write reaches them
+void checkPinnedGenomes(const std::string &path){
+    const int populationSize = 2000;
+    const uint64_t genomeLength = 4096;
+    Run run(populationSize, genomeLength);
+    RandomEngine fill(19);
+    run.randomize(fill);
+    CheckpointWriter writer;
+    for(int repetition=0;repetition<3;++repetition){
+        std::vector<uint8_t> pinned(populationSize*genomeLength);
+        for(int i=0;i<populationSize;++i){
+            std::memcpy(&pinned[i*genomeLength], run.population.genome(i), genomeLength);
+        }
+        writer.write(path, run.state);
+        for(int swap=0;swap<2;++swap){
+            for(int i=0;i<populationSize;++i){
+                std::memset(run.population.nextGenome(i), 0xee - repetition - swap, genomeLength);
+            }
+            run.population.swap();
+        }
+        writer.wait();
+        Run restored(populationSize, genomeLength);
+        loadCheckpoint(path, restored.state);
+        for(int i=0;i<populationSize;++i){
+            CHECK(!std::memcmp(&pinned[i*genomeLength], restored.population.genome(i), genomeLength));
+        }
+    }
+    std::remove(path.c_str());
+}
+
+//Corrupted checkpoints, checkpoints of another shape and unwritable paths are reported
+void checkErrors(const std::string &path){
+    Run run(500, 100);
+    RandomEngine fill(20);
+    run.randomize(fill);
+    saveCheckpoint(path, run.state);
+    std::FILE *file = std::fopen(path.c_str(), "r+b");
+    std::fseek(file, 5000, SEEK_SET);
+    int byte = std::fgetc(file);
+    std::fseek(file, 5000, SEEK_SET);
+    std::fputc(byte ^ 1, file);
+    std::fclose(file);
+    bool corrupted = false;
+    try{
+        Run restored(500, 100);
+        loadCheckpoint(path, restored.state);
+    } catch(const std::runtime_error&){
+        corrupted = true;
+    }
+    CHECK(corrupted);
+    saveCheckpoint(path, run.state);
+    bool mismatched = false;
+    try{
+        Run restored(501, 100);
+        loadCheckpoint(path, restored.state);
+    } catch(const std::runtime_error&){
+        mismatched = true;
+    }
+    CHECK(mismatched);
+    std::remove(path.c_str());
+    bool unwritable = false;
+    try{
+        CheckpointWriter writer;
+        writer.write("missing-directory/" + path, run.state);
+        writer.wait();
+    } catch(const std::system_error&){
+        unwritable = true;
+    }
+    CHECK(unwritable);
+}
+
+int main(){
+    checkResume("test-checkpoint.bin");
+    checkPinnedGenomes("test-checkpoint.bin");
+    checkErrors("test-checkpoint.bin");
+    return checkResult();
+}
@@ -0,0 +1,112 @@
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <genetic-algorithm.hpp>
+#include "check.hpp"
+
+//Parents that differ in every bit, so that each byte or bit of a child tells which parent it comes from
+void complementaryParents(uint64_t length, std::vector<uint8_t> &parent1, std::vector<uint8_t> &parent2, RandomEngine &engine){
+    parent1.resize(length);
+    parent2.resize(length);
+    for(uint64_t i=0;i<length;++i){
+        parent1[i] = uint8_t(engine());
+        parent2[i] = uint8_t(~parent1[i]);
+    }
+}
+
+//Which bytes of child come from parent1. Each must come whole from either parent
+std::vector<bool> bytesFromFirst(const std::vector<uint8_t> &parent1, const std::vector<uint8_t> &parent2, const uint8_t *child, uint64_t length){
+    std::vector<bool> fromFirst(length);
+    for(uint64_t i=0;i<length;++i){
+        CHECK(child[i]==parent1[i] || child[i]==parent2[i]);
+        fromFirst[i] = child[i]==parent1[i];
+    }
+    return fromFirst;
+}
+
+//The last 64 bytes block of a 64*b bytes genome goes through the vector blend, while a 64*b - 1 bytes genome blends the same block with the
+//same mask through the 8 bytes and single byte tail, so the two must agree. The packed crossover draws the same masks, one per word
+void checkBlendPaths(){
+    RandomEngine fill(22);
+    for(float parent1Probability : {0.5f, 0.3f, 0.01f, 0.99f}){
+        for(uint64_t length=1;length<=320;++length){
+            std::vector<uint8_t> parent1, parent2;
+            complementaryParents(length, parent1, parent2, fill);
+            //One guard byte after the child, which must be left alone
+            std::vector<uint8_t> child(length + 1, 0xa5);
+            RandomEngine engine(length);
+            uniformCrossover(parent1.data(), parent2.data(), length, child.data(), parent1Probability, engine);
+            CHECK(child[length]==0xa5);
+            std::vector<bool> fromFirst = bytesFromFirst(parent1, parent2, child.data(), length);
+            if(length%64==0){
+                std::vector<uint8_t> shorter(length - 1);
+                RandomEngine same(length);
+                uniformCrossover(parent1.data(), parent2.data(), length - 1, shorter.data(), parent1Probability, same);
+                CHECK(std::equal(shorter.begin(), shorter.end(), child.begin()));
+            }
+            uint64_t words = (length + 63)/64;
+            std::vector<uint64_t> packed1(words + 1), packed2(words + 1), packedChild(words + 1, 0xa5a5a5a5a5a5a5a5);
+            for(uint64_t w=0;w<words;++w){
+                packed1[w] = fill();
+                packed2[w] = ~packed1[w];
+            }
+            RandomEngine packedEngine(length);
+            packedUniformCrossover(packed1.data(), packed2.data(), words, packedChild.data(), parent1Probability, packedEngine);
+            CHECK(packedChild[words]==0xa5a5a5a5a5a5a5a5);
+            for(uint64_t i=0;i<length;++i){
+                bool bitFromFirst = !((packedChild[i/64] ^ packed1[i/64]) >> (i%64) & 1);
+                CHECK(bitFromFirst==fromFirst[i]);
+            }
+        }
+    }
+}
+
+//The share of parent1's bytes and bits must be parent1Probability within the 2^-16 resolution of the masks, and 5 standard deviations
+void checkBias(){
+    RandomEngine fill(23);
+    //A few full blocks and a tail of every kind
+    const uint64_t length = (1 << 22) + 63;
+    std::vector<uint8_t> parent1, parent2, child(length);
+    complementaryParents(length, parent1, parent2, fill);
+    const uint64_t words = 1 << 16;
+    std::vector<uint64_t> packed1(words), packed2(words), packedChild(words);
+    for(uint64_t w=0;w<words;++w){
+        packed1[w] = fill();
+        packed2[w] = ~packed1[w];
+    }
+    const double resolution = 1./65536;
+    for(float parent1Probability : {0.f, 1e-7f, float(resolution), 0.3f, 0.5f, 0.7f, 0.9f, float(1 - resolution), 1.f}){
+        RandomEngine engine(24);
+        uniformCrossover(parent1.data(), parent2.data(), length, child.data(), parent1Probability, engine);
+        std::vector<bool> fromFirst = bytesFromFirst(parent1, parent2, child.data(), length);
+        uint64_t bytes = 0;
+        for(bool first : fromFirst){
+            bytes += first;
+        }
+        packedUniformCrossover(packed1.data(), packed2.data(), words, packedChild.data(), parent1Probability, engine);
+        uint64_t bits = 0;
+        for(uint64_t w=0;w<words;++w){
+            for(uint64_t same=~(packedChild[w] ^ packed1[w]);same;same&=same - 1){
+                ++bits;
+            }
+        }
+        double p = parent1Probability;
+        const double counts[2][2] = {{double(bytes), double(length)}, {double(bits), 64.*words}};
+        for(const double *count : counts){
+            double share = count[0]/count[1];
+            double draws = count[1];
+            if(p<resolution/2 || p>1 - resolution/2){
+                //Rounds to a mask that's all zeros or all ones
+                CHECK(share==std::round(p));
+            } else {
+                CHECK(std::fabs(share - p)<=resolution + 5*std::sqrt(p*(1 - p)/draws));
+            }
+        }
+    }
+}
+
+int main(){
+    checkBlendPaths();
+    checkBias();
+    return checkResult();
+}
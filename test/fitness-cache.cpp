@@ -0,0 +1,102 @@
+#include <atomic>
+#include <vector>
+#include <parallel-generation.hpp>
+#include "check.hpp"
+
+std::atomic<int> evaluations{0};
+
+float countBits(const uint8_t *genome, uint64_t length){
+    ++evaluations;
+    float bits = 0;
+    for(uint64_t i=0;i<length;++i){
+        bits += float(__builtin_popcount(genome[i]));
+    }
+    return bits;
+}
+
+//Flipping any single bit, or changing the length, changes the hash, on both sides of the short genomes cutoff
+void checkHash(){
+    RandomEngine engine(9);
+    for(uint64_t length : {1, 15, 16, 63, 64, 65, 1000, 1024, 1025, 4097}){
+        std::vector<uint8_t> genome(length + 1);
+        for(uint8_t &byte : genome){
+            byte = uint8_t(engine());
+        }
+        uint64_t hash = genomeHash(genome.data(), length);
+        CHECK(hash!=genomeHash(genome.data(), length + 1));
+        for(int flip=0;flip<64;++flip){
+            uint64_t bit = engine()%(8*length);
+            genome[bit/8] ^= uint8_t(1 << (bit%8));
+            CHECK(genomeHash(genome.data(), length)!=hash);
+            genome[bit/8] ^= uint8_t(1 << (bit%8));
+        }
+        CHECK(genomeHash(genome.data(), length)==hash);
+    }
+}
+
+//Memoized generations get the fitnesses plain ones do, with fewer evaluations
+void checkMemoizedGenerations(){
+    const int populationSize = 4000;
+    //Short genomes, so that children often repeat a genome the cache already holds
+    const uint64_t genomeLength = 2;
+    ThreadPool pool(3);
+    Population plain(populationSize, genomeLength), memoized(populationSize, genomeLength);
+    RandomEngine fill(10);
+    for(int i=0;i<populationSize;++i){
+        for(uint64_t j=0;j<genomeLength;++j){
+            plain.genome(i)[j] = memoized.genome(i)[j] = uint8_t(fill());
+        }
+    }
+    FitnessCache cache(1 << 16);
+    FitnessMemo memo(cache, populationSize);
+    std::vector<float> plainFitness(populationSize), memoizedFitness(populationSize);
+    std::vector<int> winners(2*populationSize);
+    SelectionWorkspace workspace(populationSize);
+    RandomEngine plainEngine(11), memoizedEngine(11);
+    evaluateFitness(plain, plainFitness.data(), countBits, pool);
+    lookupFitness(memoized, memo, memoizedFitness.data(), pool);
+    evaluateFitness(memoized, memoizedFitness.data(), countBits, memo, pool);
+    int totalEvaluations = 0;
+    for(int generation=0;generation<30;++generation){
+        tournamentRanking(populationSize, plainFitness.data(), true, 4, winners.data(), 2*populationSize, workspace, plainEngine);
+        reproduce(plain, winners.data(), CrossoverKind::Uniform, 0.0005f, pool, plainEngine);
+        evaluateFitness(plain, plainFitness.data(), countBits, pool);
+        tournamentRanking(populationSize, memoizedFitness.data(), true, 4, winners.data(), 2*populationSize, workspace, memoizedEngine);
+        reproduce(memoized, winners.data(), CrossoverKind::Uniform, 0.0005f, nullptr, 0, memo, memoizedFitness.data(), pool, memoizedEngine);
+        evaluations = 0;
+        int memoizedEvaluations = evaluateFitness(memoized, memoizedFitness.data(), countBits, memo, pool);
+        totalEvaluations += memoizedEvaluations;
+        CHECK(evaluations==memoizedEvaluations);
+        CHECK(memoizedFitness==plainFitness);
+    }
+    //Fitness only depends on the genome, so most children reuse a cached one
+    CHECK(totalEvaluations<30*populationSize/10);
+}
+
+//A restored cache finds exactly what the saved one did
+void checkSaveRestore(){
+    FitnessCache cache(1024), restored(1024);
+    RandomEngine engine(12);
+    for(int i=0;i<3000;++i){
+        cache.insert(engine(), float(i));
+    }
+    std::vector<FitnessCacheEntry> entries;
+    cache.save(entries);
+    CHECK(!entries.empty() && entries.size()<=cache.capacity());
+    restored.restore(entries.data(), entries.size());
+    std::vector<FitnessCacheEntry> again;
+    restored.save(again);
+    CHECK(again.size()==entries.size());
+    for(size_t e=0;e<entries.size();++e){
+        float fitness = -1;
+        CHECK(restored.find(entries[e].hash, fitness) && fitness==entries[e].fitness);
+        CHECK(again[e].slot==entries[e].slot && again[e].hash==entries[e].hash);
+    }
+}
+
+int main(){
+    checkHash();
+    checkMemoizedGenerations();
+    checkSaveRestore();
+    return checkResult();
+}
@@ -0,0 +1,80 @@
+#include <vector>
+#include <fitness-index.hpp>
+#include <genetic-algorithm.hpp>
+#include "check.hpp"
+
+//The index must be ordered like rankPopulation, ties included
+void checkOrder(const FitnessIndex &index, const std::vector<float> &fitness, SelectionWorkspace &workspace){
+    int populationSize = int(fitness.size());
+    std::vector<int> ranksLookup(populationSize);
+    rankPopulation(fitness.data(), populationSize, index.maximizeFitness(), ranksLookup.data(), workspace);
+    CHECK(index.size()==populationSize);
+    for(int rank=0;rank<populationSize;++rank){
+        CHECK(index.individualAt(rank)==ranksLookup[rank]);
+        CHECK(index.rankOf(ranksLookup[rank])==rank);
+    }
+}
+
+//The index must keep the order rankPopulation gives under every kind of update, and assign must start it afresh
+void checkUpdates(){
+    const int capacity = 5000;
+    RandomEngine engine(6);
+    SelectionWorkspace workspace(capacity);
+    for(bool maximizeFitness : {true, false}){
+        std::vector<float> fitness(capacity);
+        for(float &value : fitness){
+            value = float(engine.bounded(100));
+        }
+        FitnessIndex index(capacity, maximizeFitness);
+        index.assign(fitness.data(), capacity);
+        checkOrder(index, fitness, workspace);
+        for(int step=0;step<2000;++step){
+            int individual = int(engine.bounded(capacity));
+            fitness[individual] = float(engine.bounded(100));
+            index.replace(individual, fitness[individual]);
+            CHECK(index.fitness(individual)==fitness[individual]);
+        }
+        checkOrder(index, fitness, workspace);
+        int best = index.individualAt(0), second = index.individualAt(1);
+        index.remove(best);
+        CHECK(!index.contains(best));
+        CHECK(index.size()==capacity - 1);
+        CHECK(index.individualAt(0)==second);
+        index.insert(best, fitness[best]);
+        checkOrder(index, fitness, workspace);
+        for(float &value : fitness){
+            value = float(engine.bounded(1000));
+        }
+        index.assign(fitness.data(), capacity);
+        checkOrder(index, fitness, workspace);
+    }
+}
+
+//Sampling ranks out of the index must give the winners the fitness array versions give, from the same engine state
+void checkSelections(){
+    const int populationSize = 3000;
+    RandomEngine fill(7);
+    std::vector<float> fitness(populationSize);
+    for(float &value : fitness){
+        value = fill.uniformFloat();
+    }
+    FitnessIndex index(populationSize, true);
+    index.assign(fitness.data(), populationSize);
+    SelectionWorkspace workspace(populationSize);
+    std::vector<int> expected(populationSize), winners(populationSize);
+    for(SamplingMethod method : {SamplingMethod::BinarySearch, SamplingMethod::Alias}){
+        RandomEngine engine(8), reference(8);
+        linearRanking(index, 1.6f, winners.data(), populationSize, engine, method);
+        linearRanking(populationSize, fitness.data(), true, 1.6f, expected.data(), populationSize, workspace, reference, method);
+        CHECK(winners==expected);
+        exponentialRanking(index, 0.02f, winners.data(), populationSize, engine, method);
+        exponentialRanking(populationSize, fitness.data(), true, 0.02f, expected.data(), populationSize, workspace, reference, method);
+        CHECK(winners==expected);
+    }
+}
+
+int main(){
+    checkUpdates();
+    checkSelections();
+    return checkResult();
+}
@@ -0,0 +1,86 @@
+#include <sys/wait.h>
+#include <unistd.h>
+#include <csignal>
+#include <vector>
+#include <genetic-algorithm.hpp>
+#include <genome-layout.hpp>
+#include "check.hpp"
+
+//A gene none of the blendable widths fits
+struct Rgb{
+    uint8_t r, g, b;
+};
+
+//The runtime-length operators, given the layout's loci with the extremes included, must draw the same numbers and produce the same children
+template<typename Layout>
+void checkLayout(){
+    typedef typename Layout::Gene Gene;
+    std::vector<uint64_t> genesLoci(Layout::genes + 1);
+    for(size_t i=0;i<=Layout::genes;++i){
+        genesLoci[i] = Layout::locus(i);
+    }
+    int lociLength = int(genesLoci.size());
+    RandomEngine fill(Layout::length);
+    std::vector<uint8_t> parent1(Layout::length), parent2(Layout::length), expected(Layout::length);
+    std::vector<Gene> child(Layout::genes);
+    uint8_t *bytes = reinterpret_cast<uint8_t*>(child.data());
+    for(uint64_t seed=0;seed<200;++seed){
+        for(uint64_t i=0;i<Layout::length;++i){
+            parent1[i] = uint8_t(fill());
+            parent2[i] = uint8_t(fill());
+        }
+        const Gene *genes1 = reinterpret_cast<const Gene*>(parent1.data());
+        const Gene *genes2 = reinterpret_cast<const Gene*>(parent2.data());
+
+        RandomEngine engine(seed), reference(seed);
+        twoPointsCrossover<Layout>(genes1, genes2, child.data(), engine);
+        twoPointsCrossover(parent1.data(), parent2.data(), Layout::length, expected.data(), genesLoci.data(), lociLength, reference);
+        CHECK(std::equal(expected.begin(), expected.end(), bytes));
+
+        uniformCrossover<Layout>(genes1, genes2, child.data(), engine);
+        uniformCrossover(parent1.data(), parent2.data(), Layout::length, expected.data(), genesLoci.data(), lociLength, reference);
+        CHECK(std::equal(expected.begin(), expected.end(), bytes));
+
+        for(float mutationProbability : {0.f, 0.05f, 0.5f, 1.f}){
+            expected = parent1;
+            std::copy(parent1.begin(), parent1.end(), bytes);
+            mutate<Layout>(child.data(), mutationProbability, engine);
+            mutate(expected.data(), Layout::length, genesLoci.data(), lociLength, mutationProbability, reference);
+            CHECK(std::equal(expected.begin(), expected.end(), bytes));
+        }
+        CHECK(engine()==reference());
+    }
+}
+
+//mutate<Layout> must abort on a probability outside [0, 1]. The call runs in a child process, which the assert takes down
+void checkMutationProbabilityAssert(){
+#ifndef NDEBUG
+    typedef GenomeLayout<float, 16> Layout;
+    for(float mutationProbability : {-0.5f, 1.5f}){
+        pid_t child = fork();
+        if(!child){
+            //Keep the assert's message out of the test output
+            close(STDERR_FILENO);
+            float genome[Layout::genes] = {};
+            RandomEngine engine(1);
+            mutate<Layout>(genome, mutationProbability, engine);
+            _exit(0);
+        }
+        int status = 0;
+        CHECK(waitpid(child, &status, 0)==child);
+        CHECK(WIFSIGNALED(status) && WTERMSIG(status)==SIGABRT);
+    }
+#endif
+}
+
+int main(){
+    checkLayout<GenomeLayout<uint8_t, 3>>();
+    checkLayout<GenomeLayout<uint8_t, 200>>();
+    checkLayout<GenomeLayout<uint16_t, 63>>();
+    checkLayout<GenomeLayout<float, 256>>();
+    checkLayout<GenomeLayout<double, 100>>();
+    checkLayout<GenomeLayout<uint64_t, 130>>();
+    checkLayout<GenomeLayout<Rgb, 70>>();
+    checkMutationProbabilityAssert();
+    return checkResult();
+}
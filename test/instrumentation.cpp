@@ -0,0 +1,332 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+#include <genetic-algorithm.hpp>
+#include <instrumentation.hpp>
+#include <parallel-generation.hpp>
+#include "check.hpp"
+
+//Just enough JSON for the library's outputs: objects, arrays, strings without escapes and numbers
+struct Json{
+    enum Type{Null, Number, String, Array, Object} type = Null;
+    double number = 0;
+    std::string string;
+    std::vector<Json> elements;
+    std::map<std::string, Json> members;
+
+    const Json& operator[](const std::string &key) const{
+        static const Json missing;
+        auto member = members.find(key);
+        return member==members.end() ? missing : member->second;
+    }
+};
+
+class JsonParser{
+public:
+    explicit JsonParser(const std::string &text) : text(text){}
+
+    //Parses the whole text as one value, false if it isn't valid
+    bool parse(Json &value){
+        return parseValue(value) && (skipSpaces(), position==text.size());
+    }
+
+private:
+    void skipSpaces(){
+        while(position<text.size() && std::string(" \t\r\n").find(text[position])!=std::string::npos){
+            ++position;
+        }
+    }
+
+    bool consume(char c){
+        skipSpaces();
+        if(position<text.size() && text[position]==c){
+            ++position;
+            return true;
+        }
+        return false;
+    }
+
+    bool parseString(std::string &string){
+        if(!consume('"')){
+            return false;
+        }
+        size_t end = text.find('"', position);
+        if(end==std::string::npos || text.find('\\', position)<end){
+            return false;
+        }
+        string = text.substr(position, end - position);
+        position = end + 1;
+        return true;
+    }
+
+    bool parseValue(Json &value){
+        skipSpaces();
+        if(position==text.size()){
+            return false;
+        }
+        if(text[position]=='{'){
+            value.type = Json::Object;
+            ++position;
+            if(consume('}')){
+                return true;
+            }
+            do{
+                std::string key;
+                if(!parseString(key) || !consume(':') || value.members.count(key) || !parseValue(value.members[key])){
+                    return false;
+                }
+            } while(consume(','));
+            return consume('}');
+        }
+        if(text[position]=='['){
+            value.type = Json::Array;
+            ++position;
+            if(consume(']')){
+                return true;
+            }
+            do{
+                value.elements.emplace_back();
+                if(!parseValue(value.elements.back())){
+                    return false;
+                }
+            } while(consume(','));
+            return consume(']');
+        }
+        if(text[position]=='"'){
+            value.type = Json::String;
+            return parseString(value.string);
+        }
+        value.type = Json::Number;
+        const char *begin = text.c_str() + position;
+        char *end;
+        value.number = std::strtod(begin, &end);
+        position += end - begin;
+        return end!=begin;
+    }
+
+    const std::string &text;
+    size_t position = 0;
+};
+
+std::string readFile(std::FILE *file){
+    std::string text;
+    std::rewind(file);
+    char buffer[4096];
+    for(size_t n;(n = std::fread(buffer, 1, sizeof(buffer), file))>0;){
+        text.append(buffer, n);
+    }
+    return text;
+}
+
+int bitsSet(uint64_t word){
+    int bits = 0;
+    for(;word;word&=word - 1){
+        ++bits;
+    }
+    return bits;
+}
+
+//Each call counts once under its operator, and the counters add up what the calls did
+void checkCounters(){
+    CHECK(instrumentationEnabled());
+    resetTelemetry();
+    RandomEngine engine(18);
+    const uint64_t length = 1000;
+    std::vector<uint8_t> parent1(length), parent2(length), child(length);
+    for(uint64_t i=0;i<length;++i){
+        parent1[i] = uint8_t(engine());
+        parent2[i] = uint8_t(engine());
+    }
+    uint64_t flipped = 0;
+    for(int call=0;call<5;++call){
+        std::vector<uint8_t> before = child;
+        mutate(child.data(), int(length), 0.1f, engine);
+        for(uint64_t i=0;i<length;++i){
+            flipped += bitsSet(child[i] ^ before[i]);
+        }
+    }
+    for(int call=0;call<3;++call){
+        uniformCrossover(parent1.data(), parent2.data(), length, child.data(), 0.5f, engine);
+        twoPointsCrossover(parent1.data(), parent2.data(), length, child.data(), engine);
+    }
+    TelemetrySnapshot totals = telemetryTotals();
+    CHECK(totals.generation==0);
+    CHECK(totals.operation(TelemetryOperator::Mutate).calls==5);
+    CHECK(totals.operation(TelemetryOperator::UniformCrossover).calls==3);
+    CHECK(totals.operation(TelemetryOperator::TwoPointsCrossover).calls==3);
+    CHECK(totals.operation(TelemetryOperator::PackedMutate).calls==0);
+    CHECK(flipped>0 && totals.counter(TelemetryCounter::Mutations)==flipped);
+    CHECK(totals.counter(TelemetryCounter::BytesCopied)==6*length);
+
+    //Generations count the difference since the previous one
+    TelemetrySnapshot first = generationTelemetry();
+    CHECK(first.generation==1 && first.operation(TelemetryOperator::Mutate).calls==5);
+    mutate(child.data(), int(length), 0.1f, engine);
+    TelemetrySnapshot second = generationTelemetry();
+    CHECK(second.generation==2);
+    CHECK(second.operation(TelemetryOperator::Mutate).calls==1 && second.operation(TelemetryOperator::UniformCrossover).calls==0);
+    CHECK(telemetryTotals().operation(TelemetryOperator::Mutate).calls==6);
+
+    //Counts from threads that have exited stay in the totals
+    resetTelemetry();
+    {
+        ThreadPool pool(3);
+        std::vector<float> fitness(10000);
+        for(float &value : fitness){
+            value = engine.uniformFloat();
+        }
+        std::vector<int> winners(20000);
+        SelectionWorkspace workspace(int(fitness.size()));
+        tournamentRanking(int(fitness.size()), fitness.data(), true, 3, winners.data(), int(winners.size()), pool, engine);
+    }
+    CHECK(telemetryTotals().counter(TelemetryCounter::Winners)==20000);
+}
+
+//One line per snapshot, holding every counter and operator by name with its value
+void checkJson(){
+    resetTelemetry();
+    RandomEngine engine(19);
+    std::vector<uint8_t> genome(100);
+    for(int call=0;call<4;++call){
+        mutate(genome.data(), int(genome.size()), 0.5f, engine);
+    }
+    std::unique_ptr<std::FILE, int(*)(std::FILE*)> file(std::tmpfile(), std::fclose);
+    CHECK(file!=nullptr);
+    TelemetrySnapshot first = generationTelemetry();
+    writeTelemetryJson(file.get(), first);
+    TelemetrySnapshot second = generationTelemetry();
+    writeTelemetryJson(file.get(), second);
+    std::string text = readFile(file.get());
+    CHECK(std::count(text.begin(), text.end(), '\n')==2 && text.back()=='\n');
+    const TelemetrySnapshot *snapshots[] = {&first, &second};
+    size_t begin = 0;
+    for(const TelemetrySnapshot *snapshot : snapshots){
+        size_t end = text.find('\n', begin);
+        std::string line = text.substr(begin, end - begin);
+        begin = end + 1;
+        Json json;
+        CHECK(JsonParser(line).parse(json));
+        CHECK(json.type==Json::Object);
+        CHECK(json["generation"].type==Json::Number && json["generation"].number==double(snapshot->generation));
+        for(int i=0;i<telemetryCounterCount;++i){
+            const Json &counter = json[telemetryCounterName(TelemetryCounter(i))];
+            CHECK(counter.type==Json::Number && counter.number==double(snapshot->counters[i]));
+        }
+        const Json &operators = json["operators"];
+        CHECK(operators.type==Json::Object && operators.members.size()==size_t(telemetryOperatorCount));
+        for(int i=0;i<telemetryOperatorCount;++i){
+            const Json &op = operators[telemetryOperatorName(TelemetryOperator(i))];
+            CHECK(op["calls"].type==Json::Number && op["calls"].number==double(snapshot->operators[i].calls));
+            CHECK(op["ns"].type==Json::Number && op["ns"].number==double(snapshot->operators[i].nanoseconds));
+        }
+    }
+    CHECK(first.operation(TelemetryOperator::Mutate).calls==4 && second.operation(TelemetryOperator::Mutate).calls==0);
+}
+
+//The trace's complete events, split into begin and end events, must nest on each thread: an operator called by another one, as
+//linearRanking calls rankPopulation, ends before its caller does
+void checkTrace(){
+    resetTelemetry();
+    RandomEngine engine(20);
+    const int populationSize = 5000;
+    std::vector<float> fitness(populationSize);
+    for(float &value : fitness){
+        value = engine.uniformFloat();
+    }
+    std::vector<int> winners(2*populationSize);
+    SelectionWorkspace workspace(populationSize);
+    startTelemetryTrace();
+    {
+        ThreadPool pool(3);
+        for(int generation=0;generation<3;++generation){
+            linearRanking(populationSize, fitness.data(), true, 1.5f, winners.data(), 2*populationSize, workspace, engine);
+            tournamentRanking(populationSize, fitness.data(), true, 3, winners.data(), 2*populationSize, pool, engine);
+        }
+    }
+    std::string path = "test-instrumentation-trace.json";
+    stopTelemetryTrace(path);
+    std::unique_ptr<std::FILE, int(*)(std::FILE*)> file(std::fopen(path.c_str(), "rb"), std::fclose);
+    CHECK(file!=nullptr);
+    std::string text = readFile(file.get());
+    file.reset();
+    std::remove(path.c_str());
+    Json trace;
+    CHECK(JsonParser(text).parse(trace));
+    const Json &events = trace["traceEvents"];
+    CHECK(events.type==Json::Array);
+
+    //Integer nanoseconds, from the microseconds with 3 decimals of the file
+    struct Event{
+        int64_t time;
+        bool begin;
+        int64_t partner;
+        std::string name;
+        bool operator<(const Event &other) const{
+            //At equal times, ends go first, and the later begins are the inner ones, so they go last; the opposite for the ends
+            if(time!=other.time){
+                return time<other.time;
+            }
+            if(begin!=other.begin){
+                return !begin;
+            }
+            return begin ? partner>other.partner : partner<other.partner;
+        }
+    };
+    std::map<int, std::vector<Event>> threads;
+    std::map<std::string, uint64_t> counts;
+    for(const Json &event : events.elements){
+        CHECK(event["ph"].string=="X" && event["cat"].string=="genetic-algorithm" && event["pid"].type==Json::Number);
+        CHECK(event["ts"].type==Json::Number && event["dur"].type==Json::Number && event["dur"].number>=0);
+        int64_t start = std::llround(event["ts"].number*1000);
+        int64_t end = start + std::llround(event["dur"].number*1000);
+        threads[int(event["tid"].number)].push_back({start, true, end, event["name"].string});
+        threads[int(event["tid"].number)].push_back({end, false, start, event["name"].string});
+        counts[event["name"].string]++;
+    }
+    TelemetrySnapshot totals = telemetryTotals();
+    for(int i=0;i<telemetryOperatorCount;++i){
+        std::string name = telemetryOperatorName(TelemetryOperator(i));
+        CHECK(counts[name]==totals.operators[i].calls);
+    }
+    CHECK(counts["linearRanking"]==3 && counts["rankPopulation"]>=3 && counts["tournamentRanking"]>=3);
+    bool nested = false;
+    for(auto &thread : threads){
+        std::vector<Event> &timeline = thread.second;
+        std::sort(timeline.begin(), timeline.end());
+        std::vector<const Event*> open;
+        for(const Event &event : timeline){
+            if(event.begin){
+                nested |= !open.empty();
+                open.push_back(&event);
+            } else {
+                CHECK(!open.empty() && open.back()->name==event.name && open.back()->time==event.partner);
+                if(!open.empty()){
+                    open.pop_back();
+                }
+            }
+        }
+        CHECK(open.empty());
+    }
+    CHECK(nested);
+
+    bool failed = false;
+    startTelemetryTrace();
+    try{
+        stopTelemetryTrace("no-such-directory/trace.json");
+    } catch(const std::system_error&){
+        failed = true;
+    }
+    CHECK(failed);
+}
+
+int main(){
+    checkCounters();
+    checkJson();
+    checkTrace();
+    return checkResult();
+}
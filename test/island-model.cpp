@@ -0,0 +1,195 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <island-model.hpp>
+#include <migration.hpp>
+#include "check.hpp"
+
+//Ring targets the next island, Torus the distinct neighbours on the grid, symmetrically, and Random any island but the sender, uniformly
+void checkTopologies(){
+    RandomEngine engine(16);
+    std::vector<int> targets, back;
+    for(int islands : {1, 2, 4, 6, 9, 12}){
+        for(int island=0;island<islands;++island){
+            migrationTargets(IslandTopology::Ring, island, islands, engine, targets);
+            CHECK(islands==1 ? targets.empty() : targets==std::vector<int>(1, (island + 1)%islands));
+
+            migrationTargets(IslandTopology::Torus, island, islands, engine, targets);
+            CHECK(targets.size()<=4 && (islands==1 || !targets.empty()));
+            for(int target : targets){
+                CHECK(target>=0 && target<islands && target!=island);
+                CHECK(std::count(targets.begin(), targets.end(), target)==1);
+                migrationTargets(IslandTopology::Torus, target, islands, engine, back);
+                CHECK(std::count(back.begin(), back.end(), island)==1);
+            }
+
+            const int draws = 20000;
+            std::vector<int> counts(islands);
+            for(int i=0;i<draws;++i){
+                migrationTargets(IslandTopology::Random, island, islands, engine, targets);
+                CHECK(targets.size()==(islands>1 ? 1u : 0u));
+                if(!targets.empty()){
+                    CHECK(targets[0]>=0 && targets[0]<islands);
+                    counts[targets[0]]++;
+                }
+            }
+            CHECK(counts[island]==0);
+            for(int target=0;islands>1 && target<islands;++target){
+                double p = 1./(islands - 1);
+                CHECK(target==island || std::fabs(counts[target] - draws*p)<=5*std::sqrt(draws*p*(1 - p)));
+            }
+        }
+    }
+    //A 3 by 4 grid
+    std::vector<int> expected = {1, 3, 4, 8};
+    migrationTargets(IslandTopology::Torus, 0, 12, engine, targets);
+    std::sort(targets.begin(), targets.end());
+    CHECK(targets==expected);
+    expected = {1, 4, 6, 9};
+    migrationTargets(IslandTopology::Torus, 5, 12, engine, targets);
+    std::sort(targets.begin(), targets.end());
+    CHECK(targets==expected);
+}
+
+std::vector<uint8_t> makeRecord(uint64_t recordLength, int value){
+    std::vector<uint8_t> record(recordLength);
+    for(uint64_t i=0;i<recordLength;++i){
+        record[i] = uint8_t(value*31 + i);
+    }
+    return record;
+}
+
+//Records come out in the order they went in, a full queue refuses records and an empty one has none to give, across many wraparounds
+void checkQueue(){
+    const uint64_t recordLength = 13;
+    const uint32_t slots = 4;
+    uint64_t footprint = MigrationQueue::footprint(recordLength, slots);
+    std::unique_ptr<void, void(*)(void*)> memory(std::aligned_alloc(64, (footprint + 63)/64*64), std::free);
+    MigrationQueue queue(memory.get(), recordLength, slots, true);
+    std::vector<uint8_t> record(recordLength);
+    CHECK(!queue.pop(record.data()));
+    int pushed = 0, popped = 0;
+    for(int round=0;round<50;++round){
+        //Fill up, from however many records are left in the queue
+        while(pushed - popped<int(slots)){
+            CHECK(queue.push(makeRecord(recordLength, pushed).data()));
+            ++pushed;
+        }
+        CHECK(!queue.push(makeRecord(recordLength, pushed).data()));
+        //Drain a varying number of records, all of them every few rounds
+        int drain = round%3==0 ? int(slots) : 1 + round%int(slots);
+        for(int i=0;i<drain;++i){
+            CHECK(queue.pop(record.data()));
+            CHECK(record==makeRecord(recordLength, popped));
+            ++popped;
+        }
+        if(pushed==popped){
+            CHECK(!queue.pop(record.data()));
+        }
+    }
+    //A second queue attached to the same memory sees the same records
+    MigrationQueue attached(memory.get(), recordLength, slots, false);
+    CHECK(attached.pop(record.data()));
+    CHECK(record==makeRecord(recordLength, popped));
+}
+
+//Every island sends a migrant to every other, and receives them all, whole and each exactly once
+void checkRoundTrips(MigrationTransport &sender, MigrationTransport &receiver, int islands, uint64_t genomeLength){
+    uint64_t recordLength = migrantRecordLength(genomeLength);
+    std::vector<uint8_t> record(recordLength);
+    for(int from=0;from<islands;++from){
+        for(int to=0;to<islands;++to){
+            if(from!=to){
+                std::vector<uint8_t> migrant = makeRecord(recordLength, from*islands + to);
+                MigrantHeader header = {float(from) + 0.5f, from};
+                std::memcpy(migrant.data(), &header, sizeof(header));
+                CHECK(sender.send(from, to, migrant.data()));
+            }
+        }
+    }
+    for(int to=0;to<islands;++to){
+        std::vector<int> sources;
+        while(receiver.receive(to, record.data())){
+            MigrantHeader header;
+            std::memcpy(&header, record.data(), sizeof(header));
+            CHECK(header.fitness==float(header.source) + 0.5f);
+            std::vector<uint8_t> migrant = makeRecord(recordLength, header.source*islands + to);
+            CHECK(std::equal(record.begin() + sizeof(header), record.end(), migrant.begin() + sizeof(header)));
+            sources.push_back(header.source);
+        }
+        std::sort(sources.begin(), sources.end());
+        std::vector<int> expected;
+        for(int from=0;from<islands;++from){
+            if(from!=to){
+                expected.push_back(from);
+            }
+        }
+        CHECK(sources==expected);
+    }
+}
+
+void checkInProcess(){
+    InProcessTransport transport(5, migrantRecordLength(100), 4);
+    checkRoundTrips(transport, transport, 5, 100);
+    //A full link drops the migrant
+    std::vector<uint8_t> record = makeRecord(migrantRecordLength(100), 0);
+    for(int i=0;i<4;++i){
+        CHECK(transport.send(0, 1, record.data()));
+    }
+    CHECK(!transport.send(0, 1, record.data()));
+}
+
+//The owner creates the object and another transport attaches to it, as another process would. Destroying the owner unlinks the name
+void checkSharedMemory(){
+    std::string name = "/genetic-algorithm-test-" + std::to_string(getpid());
+    {
+        SharedMemoryTransport owner(name, 4, migrantRecordLength(64), 8, true);
+        SharedMemoryTransport attached(name, 4, migrantRecordLength(64), 8, false);
+        checkRoundTrips(owner, attached, 4, 64);
+        checkRoundTrips(attached, owner, 4, 64);
+    }
+    errno = 0;
+    CHECK(shm_open(name.c_str(), O_RDONLY, 0)<0 && errno==ENOENT);
+}
+
+//Two transports split the islands between them, as two processes would. Each unlinks the sockets it bound
+void checkSockets(){
+    std::string directory = "/tmp/genetic-algorithm-test-" + std::to_string(getpid());
+    CHECK(mkdir(directory.c_str(), 0700)==0);
+    {
+        SocketTransport even(directory, 4, migrantRecordLength(200), {0, 2});
+        SocketTransport odd(directory, 4, migrantRecordLength(200), {1, 3});
+        std::vector<uint8_t> record(migrantRecordLength(200));
+        CHECK(!even.receive(0, record.data()));
+        std::vector<uint8_t> migrant = makeRecord(record.size(), 7);
+        CHECK(even.send(0, 1, migrant.data()));
+        CHECK(odd.receive(1, record.data()));
+        CHECK(record==migrant);
+        CHECK(!odd.receive(1, record.data()));
+        CHECK(odd.send(3, 2, migrant.data()));
+        CHECK(even.receive(2, record.data()));
+        CHECK(record==migrant);
+    }
+    for(int island=0;island<4;++island){
+        CHECK(access((directory + "/island-" + std::to_string(island)).c_str(), F_OK)!=0);
+    }
+    CHECK(rmdir(directory.c_str())==0);
+}
+
+int main(){
+    checkTopologies();
+    checkQueue();
+    checkInProcess();
+    checkSharedMemory();
+    checkSockets();
+    return checkResult();
+}
@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <multi-objective.hpp>
+#include <thread-pool.hpp>
+#include "check.hpp"
+
+//The fronts by definition: peel off the individuals no remaining one dominates, one front at a time
+std::vector<int> bruteForceFronts(const std::vector<float> &objectives, int objectivesCount, int populationSize, bool maximizeFitness){
+    auto dominates = [&](int a, int b){
+        bool better = false;
+        for(int objective=0;objective<objectivesCount;++objective){
+            float x = objectives[objective*populationSize + a], y = objectives[objective*populationSize + b];
+            if(maximizeFitness ? x<y : x>y){
+                return false;
+            }
+            better |= x!=y;
+        }
+        return better;
+    };
+    std::vector<int> fronts(populationSize, -1);
+    for(int front=0, assigned=0;assigned<populationSize;++front){
+        std::vector<int> members;
+        for(int i=0;i<populationSize;++i){
+            bool dominated = false;
+            for(int j=0;j<populationSize && fronts[i]<0 && !dominated;++j){
+                dominated = fronts[j]<0 && dominates(j, i);
+            }
+            if(fronts[i]<0 && !dominated){
+                members.push_back(i);
+            }
+        }
+        for(int i : members){
+            fronts[i] = front;
+        }
+        assigned += int(members.size());
+    }
+    return fronts;
+}
+
+//The crowding distances by definition, one objective and one front at a time
+std::vector<float> bruteForceCrowding(const std::vector<float> &objectives, int objectivesCount, int populationSize, const std::vector<int> &fronts){
+    std::vector<float> distances(populationSize);
+    int frontsCount = *std::max_element(fronts.begin(), fronts.end()) + 1;
+    for(int objective=0;objective<objectivesCount;++objective){
+        const float *values = objectives.data() + objective*populationSize;
+        for(int front=0;front<frontsCount;++front){
+            std::vector<int> members;
+            for(int i=0;i<populationSize;++i){
+                if(fronts[i]==front){
+                    members.push_back(i);
+                }
+            }
+            std::stable_sort(members.begin(), members.end(), [&](int a, int b){
+                return values[a]<values[b];
+            });
+            distances[members.front()] = distances[members.back()] = std::numeric_limits<float>::infinity();
+            float extent = values[members.back()] - values[members.front()];
+            for(size_t m=1;extent>0 && m + 1<members.size();++m){
+                distances[members[m]] += (values[members[m + 1]] - values[members[m - 1]])/extent;
+            }
+        }
+    }
+    return distances;
+}
+
+int main(){
+    RandomEngine engine(13);
+    ThreadPool pool(4);
+    ParetoWorkspace workspace;
+    //One to five objectives, covering the two objectives sweep and the divide and conquer, with many ties or none
+    for(int trial=0;trial<150;++trial){
+        int objectivesCount = 1 + trial%5;
+        int populationSize = 1 + int(engine.bounded(trial<100 ? 300 : 1500));
+        bool maximizeFitness = trial%2;
+        int levels = trial%3==0 ? 4 : trial%3==1 ? 30 : 1000000;
+        std::vector<float> objectives(objectivesCount*populationSize);
+        for(float &value : objectives){
+            value = float(int(engine.bounded(levels)) - levels/2);
+        }
+        if(trial%7==0){
+            std::fill(objectives.begin(), objectives.begin() + populationSize, -0.f);
+        }
+        std::vector<int> expected = bruteForceFronts(objectives, objectivesCount, populationSize, maximizeFitness);
+        workspace.reserve(populationSize, objectivesCount);
+        std::vector<int> fronts(populationSize), parallelFronts(populationSize);
+        int frontsCount = nonDominatedSort(objectives.data(), objectivesCount, populationSize, maximizeFitness, fronts.data(), workspace);
+        CHECK(frontsCount==*std::max_element(expected.begin(), expected.end()) + 1);
+        CHECK(fronts==expected);
+        nonDominatedSort(objectives.data(), objectivesCount, populationSize, maximizeFitness, parallelFronts.data(), workspace, pool);
+        CHECK(parallelFronts==expected);
+        std::vector<float> expectedDistances = bruteForceCrowding(objectives, objectivesCount, populationSize, expected);
+        std::vector<float> distances(populationSize), parallelDistances(populationSize);
+        crowdingDistance(objectives.data(), objectivesCount, populationSize, fronts.data(), distances.data(), workspace);
+        crowdingDistance(objectives.data(), objectivesCount, populationSize, fronts.data(), parallelDistances.data(), workspace, pool);
+        CHECK(parallelDistances==distances);
+        for(int i=0;i<populationSize;++i){
+            CHECK(distances[i]==expectedDistances[i] || std::fabs(distances[i] - expectedDistances[i])<1e-4f);
+        }
+    }
+    //Crowded tournaments don't depend on the size of the pool
+    const int populationSize = 20000;
+    std::vector<float> objectives(3*populationSize);
+    for(float &value : objectives){
+        value = engine.uniformFloat();
+    }
+    std::vector<int> winners(populationSize), parallelWinners(populationSize);
+    workspace.reserve(populationSize, 3);
+    RandomEngine serialEngine(14), parallelEngine(14);
+    crowdedTournamentRanking(populationSize, objectives.data(), 3, false, 2, winners.data(), populationSize, workspace, serialEngine);
+    crowdedTournamentRanking(populationSize, objectives.data(), 3, false, 2, parallelWinners.data(), populationSize, workspace, pool, parallelEngine);
+    CHECK(parallelWinners==winners);
+    return checkResult();
+}
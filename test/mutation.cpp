@@ -0,0 +1,117 @@
+#include <cmath>
+#include <vector>
+#include <genetic-algorithm.hpp>
+#include "check.hpp"
+
+int bitsSet(uint64_t word){
+    int bits = 0;
+    for(;word;word&=word - 1){
+        ++bits;
+    }
+    return bits;
+}
+
+//Within 5 standard deviations of mutationProbability, or exactly 0 or 1 at the extremes
+bool matchesRate(uint64_t mutated, uint64_t trials, double mutationProbability){
+    if(mutationProbability==0 || mutationProbability==1){
+        return mutated==uint64_t(mutationProbability)*trials;
+    }
+    double expected = trials*mutationProbability;
+    return std::fabs(mutated - expected)<=5*std::sqrt(expected*(1 - mutationProbability)) + 1;
+}
+
+const float probabilities[] = {0.f, 1e-4f, 0.01f, 0.3f, 0.9f, 1.f};
+
+//Each byte mutates at most once, by a single bit, so every mutated byte is one bit away from the original. Mutating the first byte over and
+//over instead, as mutate once did, leaves the rest untouched
+void checkByteMutate(){
+    RandomEngine engine(8);
+    const int length = 1 << 20;
+    std::vector<uint8_t> original(length + 1), individual;
+    for(uint8_t &byte : original){
+        byte = uint8_t(engine());
+    }
+    for(float mutationProbability : probabilities){
+        individual = original;
+        mutate(individual.data(), length, mutationProbability, engine);
+        CHECK(individual[length]==original[length]);
+        uint64_t mutated = 0;
+        for(int i=0;i<length;++i){
+            int flipped = bitsSet(individual[i] ^ original[i]);
+            CHECK(flipped<=1);
+            mutated += flipped;
+        }
+        CHECK(matchesRate(mutated, length, mutationProbability));
+    }
+}
+
+//A length that isn't a multiple of 64, so that the bits past the end of the last word are there to be left alone
+void checkPackedMutate(){
+    RandomEngine engine(9);
+    const uint64_t bits = (1 << 22) + 37;
+    const uint64_t words = (bits + 63)/64;
+    std::vector<uint64_t> original(words + 1), individual;
+    for(uint64_t &word : original){
+        word = engine();
+    }
+    for(float mutationProbability : probabilities){
+        individual = original;
+        packedMutate(individual.data(), bits, mutationProbability, engine);
+        CHECK(individual[words]==original[words]);
+        CHECK((individual[words - 1] ^ original[words - 1]) >> (bits%64)==0);
+        uint64_t mutated = 0;
+        for(uint64_t w=0;w<words;++w){
+            mutated += bitsSet(individual[w] ^ original[w]);
+        }
+        CHECK(matchesRate(mutated, bits, mutationProbability));
+    }
+}
+
+//Genes from 0 to 9 bytes long, the empty ones as repeated loci, with the extremes left out of genesLoci. A mutated gene has exactly one bit
+//flipped somewhere within its own bytes, and an empty gene can't mutate at all
+void checkGeneMutate(){
+    RandomEngine engine(10);
+    std::vector<uint64_t> genesLoci;
+    uint64_t length = 3;
+    for(int gene=0;gene<100000;++gene){
+        genesLoci.push_back(length);
+        length += gene%10;
+    }
+    uint64_t end = length;
+    length += 5;
+    std::vector<uint8_t> original(length + 1), individual;
+    for(uint8_t &byte : original){
+        byte = uint8_t(engine());
+    }
+    //The genes, with the extremes back in
+    std::vector<uint64_t> bounds(1, 0);
+    bounds.insert(bounds.end(), genesLoci.begin(), genesLoci.end());
+    bounds.push_back(length);
+    CHECK(end<length);
+    for(float mutationProbability : probabilities){
+        individual = original;
+        mutate(individual.data(), length, genesLoci.data(), int(genesLoci.size()), mutationProbability, engine);
+        CHECK(individual[length]==original[length]);
+        uint64_t mutated = 0, genes = 0;
+        for(uint64_t g=0;g + 1<bounds.size();++g){
+            int flipped = 0;
+            for(uint64_t i=bounds[g];i<bounds[g + 1];++i){
+                flipped += bitsSet(individual[i] ^ original[i]);
+            }
+            CHECK(flipped<=1);
+            if(bounds[g + 1]>bounds[g]){
+                mutated += flipped;
+                ++genes;
+            }
+        }
+        //The empty genes still take their turn with the skips, so the non-empty ones mutate at a rate of mutationProbability
+        CHECK(matchesRate(mutated, genes, mutationProbability));
+    }
+}
+
+int main(){
+    checkByteMutate();
+    checkPackedMutate();
+    checkGeneMutate();
+    return checkResult();
+}
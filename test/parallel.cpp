@@ -0,0 +1,65 @@
+#include <cstring>
+#include <vector>
+#include <parallel-generation.hpp>
+#include "check.hpp"
+
+float countBits(const uint8_t *genome, uint64_t length){
+    float bits = 0;
+    for(uint64_t i=0;i<length;++i){
+        bits += float(__builtin_popcount(genome[i]));
+    }
+    return bits;
+}
+
+//Everything a few generations draw, for a given pool size
+struct Trace{
+    std::vector<int> winners;
+    std::vector<float> fitness;
+    std::vector<uint8_t> genomes;
+};
+
+Trace runGenerations(ThreadPool &pool){
+    const int populationSize = 20000;
+    const uint64_t genomeLength = 40;
+    RandomEngine engine(7);
+    Population population(populationSize, genomeLength);
+    for(int i=0;i<populationSize;++i){
+        for(uint64_t j=0;j<genomeLength;++j){
+            population.genome(i)[j] = uint8_t(engine());
+        }
+    }
+    SelectionWorkspace workspace(populationSize);
+    std::vector<float> fitness(populationSize);
+    std::vector<int> winners(2*populationSize);
+    Trace trace;
+    for(int generation=0;generation<4;++generation){
+        evaluateFitness(population, fitness.data(), countBits, pool);
+        trace.fitness.insert(trace.fitness.end(), fitness.begin(), fitness.end());
+        rouletteRanking(populationSize, fitness.data(), winners.data(), 2*populationSize, workspace, pool, engine);
+        trace.winners.insert(trace.winners.end(), winners.begin(), winners.end());
+        exponentialRanking(populationSize, fitness.data(), true, 0.05f, winners.data(), 2*populationSize, workspace, pool, engine);
+        trace.winners.insert(trace.winners.end(), winners.begin(), winners.end());
+        tournamentRanking(populationSize, fitness.data(), true, 3, winners.data(), 2*populationSize, pool, engine);
+        trace.winners.insert(trace.winners.end(), winners.begin(), winners.end());
+        linearRanking(populationSize, fitness.data(), true, 1.6f, winners.data(), 2*populationSize, workspace, pool, engine);
+        trace.winners.insert(trace.winners.end(), winners.begin(), winners.end());
+        reproduce(population, winners.data(), generation%2 ? CrossoverKind::TwoPoints : CrossoverKind::Uniform, 0.01f, pool, engine);
+    }
+    for(int i=0;i<populationSize;++i){
+        trace.genomes.insert(trace.genomes.end(), population.genome(i), population.genome(i) + genomeLength);
+    }
+    return trace;
+}
+
+int main(){
+    ThreadPool serial(1);
+    Trace expected = runGenerations(serial);
+    for(int threads : {2, 5}){
+        ThreadPool pool(threads);
+        Trace trace = runGenerations(pool);
+        CHECK(trace.winners==expected.winners);
+        CHECK(trace.fitness==expected.fitness);
+        CHECK(trace.genomes==expected.genomes);
+    }
+    return checkResult();
+}
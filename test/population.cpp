@@ -0,0 +1,141 @@
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <population.hpp>
+#include "check.hpp"
+
+//A flushed mapped population reopens with the same genomes, and corrupted headers are rejected
+void checkMappedPopulation(const std::string &path){
+    const int populationSize = 300;
+    const uint64_t genomeLength = 100;
+    {
+        Population population(populationSize, genomeLength, path);
+        for(int i=0;i<populationSize;++i){
+            std::memset(population.nextGenome(i), i, genomeLength);
+        }
+        population.swap();
+        population.flush();
+    }
+    {
+        Population population(path);
+        CHECK(population.size()==populationSize);
+        CHECK(population.genomeLength()==genomeLength);
+        for(int i=0;i<populationSize;++i){
+            CHECK(population.genome(i)[0]==uint8_t(i) && population.genome(i)[genomeLength - 1]==uint8_t(i));
+        }
+    }
+    //The header is magic, version, size, genomeLength, stride and current, 8 bytes each
+    struct Corruption{
+        long offset;
+        uint64_t value;
+    };
+    for(Corruption corruption : {Corruption{24, 0}, Corruption{24, 1000}, Corruption{32, 100}, Corruption{40, 3}}){
+        std::FILE *file = std::fopen(path.c_str(), "r+b");
+        uint64_t saved;
+        std::fseek(file, corruption.offset, SEEK_SET);
+        CHECK(std::fread(&saved, sizeof(saved), 1, file)==1);
+        std::fseek(file, corruption.offset, SEEK_SET);
+        std::fwrite(&corruption.value, sizeof(corruption.value), 1, file);
+        std::fclose(file);
+        bool rejected = false;
+        try{
+            Population population(path);
+        } catch(const std::runtime_error&){
+            rejected = true;
+        }
+        CHECK(rejected);
+        file = std::fopen(path.c_str(), "r+b");
+        std::fseek(file, corruption.offset, SEEK_SET);
+        std::fwrite(&saved, sizeof(saved), 1, file);
+        std::fclose(file);
+    }
+    std::remove(path.c_str());
+}
+
+//A reader that outlasts several swaps keeps reading the genomes where they were pinned, untouched by the generations written meanwhile, and
+//the population carries on around them. A mapped population reopens at the right arena afterwards, whichever of the three it ended on
+void checkPinnedGenomes(Population &population){
+    const int populationSize = population.size();
+    const uint64_t genomeLength = population.genomeLength();
+    for(int repetition=0;repetition<3;++repetition){
+        for(int i=0;i<populationSize;++i){
+            std::memset(population.genome(i), (i + repetition)%200, genomeLength);
+        }
+        std::vector<const uint8_t*> addresses(populationSize);
+        for(int i=0;i<populationSize;++i){
+            addresses[i] = population.genome(i);
+        }
+        std::shared_ptr<PinnedGenomes> pinned = population.pin();
+        CHECK(pinned->size()==populationSize && pinned->genomeLength()==genomeLength);
+        auto visit = [&](int i, const uint8_t *genome){
+            CHECK(genome==addresses[i]);
+            CHECK(genome[0]==(i + repetition)%200 && genome[genomeLength - 1]==(i + repetition)%200);
+        };
+        pinned->read(0, populationSize/3, visit);
+        for(int swap=0;swap<1 + repetition;++swap){
+            for(int i=0;i<populationSize;++i){
+                std::memset(population.nextGenome(i), 0xee - swap, genomeLength);
+            }
+            population.swap();
+            CHECK(population.genome(populationSize - 1)[0]==0xee - swap);
+        }
+        pinned->read(populationSize/3, populationSize, visit);
+        pinned->release();
+    }
+    population.swap();
+    if(population.mapped()){
+        for(int i=0;i<populationSize;++i){
+            std::memset(population.genome(i), i%100, genomeLength);
+        }
+        population.flush();
+    }
+}
+
+//twoPointsCrossover always gives the child its first byte from parent1. Every pair of individuals 2k and 2k+1 is picked twice, once in each
+//order, so exactly half the children must start like an even individual, whatever order reproduce schedules the pairs in
+void checkParentRoles(){
+    const int populationSize = 256;
+    const uint64_t genomeLength = 64;
+    Population population(populationSize, genomeLength);
+    for(int i=0;i<populationSize;++i){
+        std::memset(population.genome(i), i, genomeLength);
+    }
+    std::vector<int> winners(2*populationSize);
+    for(int child=0;child<populationSize;++child){
+        int pair = child%(populationSize/2);
+        bool swapped = child>=populationSize/2;
+        winners[2*child] = 2*pair + swapped;
+        winners[2*child + 1] = 2*pair + !swapped;
+    }
+    RandomEngine engine(8);
+    reproduce(population, winners.data(), CrossoverKind::TwoPoints, 0, nullptr, 0, engine);
+    int evenFirst = 0;
+    for(int child=0;child<populationSize;++child){
+        evenFirst += population.genome(child)[0]%2==0;
+    }
+    CHECK(evenFirst==populationSize/2);
+}
+
+int main(){
+    checkMappedPopulation("test-population.bin");
+    {
+        Population population(300, 100);
+        checkPinnedGenomes(population);
+    }
+    {
+        Population population(300, 100, "test-population.bin");
+        checkPinnedGenomes(population);
+    }
+    {
+        Population population("test-population.bin");
+        for(int i=0;i<population.size();++i){
+            CHECK(population.genome(i)[0]==i%100 && population.genome(i)[99]==i%100);
+        }
+    }
+    std::remove("test-population.bin");
+    checkParentRoles();
+    return checkResult();
+}
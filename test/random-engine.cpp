@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <set>
+#include <vector>
+#include <random-engine.hpp>
+#include "check.hpp"
+
+typedef std::array<uint64_t, 4> State;
+
+//The sum of the columns of matrix selected by the bits of state, over GF(2)
+State multiply(const std::vector<State> &matrix, const State &state){
+    State result = {};
+    for(int bit=0;bit<256;++bit){
+        if((state[bit/64] >> (bit%64)) & 1){
+            for(int word=0;word<4;++word){
+                result[word] ^= matrix[bit][word];
+            }
+        }
+    }
+    return result;
+}
+
+//xoshiro256**'s transition is linear over GF(2), so jumping 2^128 steps is multiplying by its matrix squared 128 times. This checks
+//jump() against the definition of the jump rather than against the published polynomial it's implemented with
+void checkJump(){
+    std::vector<State> transition(256);
+    for(int bit=0;bit<256;++bit){
+        RandomEngine engine(0);
+        State unit = {};
+        unit[bit/64] = uint64_t(1) << (bit%64);
+        std::copy(unit.begin(), unit.end(), engine.state);
+        engine();
+        std::copy(engine.state, engine.state + 4, transition[bit].begin());
+    }
+    for(int squaring=0;squaring<128;++squaring){
+        std::vector<State> squared(256);
+        for(int bit=0;bit<256;++bit){
+            squared[bit] = multiply(transition, transition[bit]);
+        }
+        transition.swap(squared);
+    }
+    for(uint64_t seed : {0, 1, 12345}){
+        RandomEngine engine(seed);
+        State state;
+        std::copy(engine.state, engine.state + 4, state.begin());
+        State expected = multiply(transition, state);
+        engine.jump();
+        CHECK(std::equal(expected.begin(), expected.end(), engine.state));
+    }
+}
+
+//Seeding is deterministic, and the streams of a seed, like the seeds themselves, don't resemble each other
+void checkSeeding(){
+    RandomEngine a(42), b(42), c(1);
+    c.seed(42);
+    for(int i=0;i<1000;++i){
+        uint64_t value = a();
+        CHECK(b()==value && c()==value);
+    }
+    CHECK(RandomEngine(42, 7)()==RandomEngine(42, 7)());
+    std::set<uint64_t> firsts;
+    const int streams = 1000;
+    for(int stream=0;stream<streams;++stream){
+        firsts.insert(RandomEngine(42, stream)());
+        firsts.insert(RandomEngine(stream)());
+    }
+    CHECK(firsts.size()==2*streams);
+    //Neighbouring streams and neighbouring seeds differ in half of their bits on average
+    for(int neighbour=0;neighbour<2;++neighbour){
+        uint64_t differingBits = 0;
+        const int draws = 10000;
+        for(int stream=0;stream<draws/100;++stream){
+            RandomEngine first = neighbour ? RandomEngine(42, stream) : RandomEngine(stream);
+            RandomEngine second = neighbour ? RandomEngine(42, stream + 1) : RandomEngine(stream + 1);
+            for(int i=0;i<100;++i){
+                uint64_t difference = first() ^ second();
+                for(;difference;difference&=difference - 1){
+                    ++differingBits;
+                }
+            }
+        }
+        double average = double(differingBits)/draws;
+        CHECK(average>31.5 && average<32.5);
+    }
+}
+
+void checkBounded(){
+    RandomEngine engine(3);
+    for(uint32_t range : {1u, 2u, 3u, 10u, 1000u, (1u << 31) + 1, UINT32_MAX}){
+        std::vector<int> hits(std::min(range, 1000u));
+        uint32_t largest = 0;
+        for(int i=0;i<100000;++i){
+            uint32_t value = engine.bounded(range);
+            CHECK(value<range);
+            largest = std::max(largest, value);
+            if(range<=1000){
+                hits[value]++;
+            }
+        }
+        CHECK(range<=1000 ? std::count(hits.begin(), hits.end(), 0)==0 : largest>range/2);
+    }
+    for(uint64_t range : {uint64_t(1), uint64_t(3), (uint64_t(1) << 32) + 15, (uint64_t(1) << 40) + 3, UINT64_MAX}){
+        double sum = 0;
+        uint64_t largest = 0;
+        const int draws = 100000;
+        for(int i=0;i<draws;++i){
+            uint64_t value = engine.bounded64(range);
+            CHECK(value<range);
+            largest = std::max(largest, value);
+            sum += double(value)/double(range);
+        }
+        CHECK(range<4 || (largest>range/2 && sum/draws>0.49 && sum/draws<0.51));
+    }
+    //The exact results: the draw scaled by range/2^64
+    for(int i=0;i<1000;++i){
+        RandomEngine copy = engine;
+        uint64_t word = copy();
+        CHECK(engine.bounded64(UINT64_MAX)==word - (word!=0));
+        copy = engine;
+        word = copy();
+        CHECK(engine.bounded64(uint64_t(1) << 40)==word >> 24);
+    }
+}
+
+int main(){
+    checkJump();
+    checkSeeding();
+    checkBounded();
+    return checkResult();
+}
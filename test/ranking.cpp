@@ -0,0 +1,55 @@
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <vector>
+#include <genetic-algorithm.hpp>
+#include <thread-pool.hpp>
+#include "check.hpp"
+
+//The order rankPopulation must produce: best fitness first, ties in order of index
+std::vector<int> stableRanking(const std::vector<float> &fitness, bool maximizeFitness){
+    std::vector<int> ranksLookup(fitness.size());
+    std::iota(ranksLookup.begin(), ranksLookup.end(), 0);
+    std::stable_sort(ranksLookup.begin(), ranksLookup.end(), [&](int a, int b){
+        return maximizeFitness ? fitness[a]>fitness[b] : fitness[a]<fitness[b];
+    });
+    return ranksLookup;
+}
+
+//Few distinct values, so that there are many ties, of both signs and with infinities
+std::vector<float> randomFitness(int populationSize, int levels, RandomEngine &engine){
+    std::vector<float> fitness(populationSize);
+    for(float &value : fitness){
+        value = float(int(engine.bounded(levels)) - levels/2)*0.25f;
+    }
+    fitness[engine.bounded(populationSize)] = std::numeric_limits<float>::infinity();
+    fitness[engine.bounded(populationSize)] = -std::numeric_limits<float>::infinity();
+    return fitness;
+}
+
+int main(){
+    RandomEngine engine(1);
+    ThreadPool pool(4);
+    SelectionWorkspace workspace;
+    //Both sides of the cutoff between std::sort and the radix sort, and one big enough for the parallel runs
+    for(int populationSize : {1, 2, 100, radixRankingThreshold - 1, radixRankingThreshold, radixRankingThreshold + 1, 200000}){
+        for(int levels : {3, 1000, 1 << 30}){
+            std::vector<float> fitness = randomFitness(populationSize, levels, engine);
+            for(bool maximizeFitness : {true, false}){
+                std::vector<int> expected = stableRanking(fitness, maximizeFitness);
+                std::vector<int> ranksLookup(populationSize);
+                workspace.reserve(populationSize);
+                rankPopulation(fitness.data(), populationSize, maximizeFitness, ranksLookup.data(), workspace);
+                CHECK(ranksLookup==expected);
+                std::fill(ranksLookup.begin(), ranksLookup.end(), -1);
+                rankPopulation(fitness.data(), populationSize, maximizeFitness, ranksLookup.data(), workspace, pool);
+                CHECK(ranksLookup==expected);
+                int count = std::min(populationSize, 37);
+                std::vector<int> best(count);
+                partialRankPopulation(fitness.data(), populationSize, maximizeFitness, count, best.data(), workspace);
+                CHECK(std::equal(best.begin(), best.end(), expected.begin()));
+            }
+        }
+    }
+    return checkResult();
+}
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <real-operators.hpp>
+#include "check.hpp"
+
+//Parents in [lower, upper], some of them on the bounds, with the bounds differing from gene to gene
+template<typename Real>
+struct Genomes{
+    static const uint64_t genes = 200;
+    static const int rows = 40;
+    std::vector<Real> lower, upper, parents;
+
+    explicit Genomes(RandomEngine &engine) : lower(genes), upper(genes), parents(rows*genes){
+        for(uint64_t g=0;g<genes;++g){
+            lower[g] = Real(-1) - Real(g%7);
+            upper[g] = Real(g%5) + Real(0.25);
+        }
+        std::vector<Real> uniforms(rows*genes);
+        uniformReals(engine, uniforms.data(), uniforms.size());
+        for(uint64_t i=0;i<parents.size();++i){
+            uint64_t g = i%genes;
+            parents[i] = i%37==0 ? lower[g] : i%41==0 ? upper[g] : lower[g] + uniforms[i]*(upper[g] - lower[g]);
+        }
+    }
+
+    const Real* row(int i) const { return parents.data() + i*genes; }
+
+    bool inBounds(const Real *genome) const{
+        for(uint64_t g=0;g<genes;++g){
+            if(!(genome[g]>=lower[g] && genome[g]<=upper[g])){
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+//SBX and BLX-alpha children, and mutated genomes, never leave the bounds, in the single and batched forms alike
+template<typename Real>
+void checkBounds(){
+    RandomEngine engine(13);
+    Genomes<Real> genomes(engine);
+    const uint64_t genes = Genomes<Real>::genes;
+    const int rows = Genomes<Real>::rows;
+    std::vector<Real> child(genes), offspring(rows*genes);
+    std::vector<int> pairs(2*rows);
+    for(int i=0;i<2*rows;++i){
+        pairs[i] = int(engine.bounded(rows));
+    }
+    const Real *lower = genomes.lower.data(), *upper = genomes.upper.data();
+    for(int i=0;i + 1<rows;++i){
+        for(float distributionIndex : {0.f, 2.f, 20.f}){
+            simulatedBinaryCrossover(genomes.row(i), genomes.row(i + 1), genes, child.data(), distributionIndex, lower, upper, engine);
+            CHECK(genomes.inBounds(child.data()));
+        }
+        for(float alpha : {0.f, 0.5f, 3.f}){
+            blendCrossover(genomes.row(i), genomes.row(i + 1), genes, child.data(), alpha, lower, upper, engine);
+            CHECK(genomes.inBounds(child.data()));
+        }
+    }
+    simulatedBinaryCrossover(genomes.parents.data(), pairs.data(), rows, genes, genes, offspring.data(), 1.f, lower, upper, engine);
+    for(int i=0;i<rows;++i){
+        CHECK(genomes.inBounds(offspring.data() + i*genes));
+    }
+    blendCrossover(genomes.parents.data(), pairs.data(), rows, genes, genes, offspring.data(), 1.f, lower, upper, engine);
+    for(int i=0;i<rows;++i){
+        CHECK(genomes.inBounds(offspring.data() + i*genes));
+    }
+    //Repeated mutations drift the genomes towards the bounds, which they must stop at
+    std::vector<Real> individuals = genomes.parents;
+    for(int generation=0;generation<20;++generation){
+        polynomialMutate(individuals.data(), rows, genes, genes, 1.f, generation%2 ? 0.f : 20.f, lower, upper, engine);
+        for(int i=0;i<rows;++i){
+            CHECK(genomes.inBounds(individuals.data() + i*genes));
+        }
+        gaussianMutate(individuals.data(), rows, genes, genes, 0.5f, 2.f, lower, upper, engine);
+        for(int i=0;i<rows;++i){
+            CHECK(genomes.inBounds(individuals.data() + i*genes));
+        }
+    }
+    CHECK(individuals!=genomes.parents);
+}
+
+//The child is exactly parent2 + weight*(parent1 - parent2), the weight being the engine's next uniformReals
+template<typename Real>
+void checkArithmetic(){
+    RandomEngine engine(14);
+    Genomes<Real> genomes(engine);
+    const uint64_t genes = Genomes<Real>::genes;
+    std::vector<Real> child(genes);
+    for(int i=0;i + 1<Genomes<Real>::rows;++i){
+        const Real *parent1 = genomes.row(i), *parent2 = genomes.row(i + 1);
+        RandomEngine copy = engine;
+        Real weight;
+        uniformReals(copy, &weight, 1);
+        CHECK(weight>=0 && weight<1);
+        arithmeticCrossover(parent1, parent2, genes, child.data(), engine);
+        for(uint64_t g=0;g<genes;++g){
+            CHECK(child[g]==parent2[g] + weight*(parent1[g] - parent2[g]));
+        }
+        CHECK(copy()==engine());
+    }
+}
+
+//Swapping the parents negates every offset from their mean, so with the same draws the two children add up to the sum of the parents, and
+//each child lands above the mean as often as below it
+template<typename Real>
+void checkSimulatedBinarySymmetry(){
+    RandomEngine engine(15);
+    Genomes<Real> genomes(engine);
+    const uint64_t genes = Genomes<Real>::genes;
+    std::vector<Real> child(genes), swapped(genes);
+    uint64_t above = 0, draws = 0;
+    for(int i=0;i + 1<Genomes<Real>::rows;++i){
+        const Real *parent1 = genomes.row(i), *parent2 = genomes.row(i + 1);
+        RandomEngine copy = engine;
+        simulatedBinaryCrossover(parent1, parent2, genes, child.data(), 5.f, (const Real*)nullptr, (const Real*)nullptr, engine);
+        simulatedBinaryCrossover(parent2, parent1, genes, swapped.data(), 5.f, (const Real*)nullptr, (const Real*)nullptr, copy);
+        for(uint64_t g=0;g<genes;++g){
+            Real sum = parent1[g] + parent2[g];
+            Real tolerance = 8*std::numeric_limits<Real>::epsilon()*(std::fabs(child[g]) + std::fabs(swapped[g]) + std::fabs(sum));
+            CHECK(std::fabs(child[g] + swapped[g] - sum)<=tolerance);
+            if(parent1[g]!=parent2[g]){
+                above += child[g]>sum/2;
+                ++draws;
+            }
+        }
+    }
+    CHECK(std::fabs(double(above) - draws/2.)<=5*std::sqrt(draws/4.));
+}
+
+template<typename Real>
+void checkOperators(){
+    checkBounds<Real>();
+    checkArithmetic<Real>();
+    checkSimulatedBinarySymmetry<Real>();
+}
+
+int main(){
+    checkOperators<float>();
+    checkOperators<double>();
+    return checkResult();
+}
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+#include <genetic-algorithm.hpp>
+#include "check.hpp"
+
+//Every sampling method must draw each index with its probability, within 5 standard deviations
+void checkFrequencies(){
+    RandomEngine engine(2);
+    const int size = 50;
+    std::vector<float> cumulativeWeights(size);
+    float total = 0;
+    for(int i=0;i<size;++i){
+        //Zero weights included, which must never be drawn
+        total += i%7==3 ? 0.f : float(1 + i%5);
+        cumulativeWeights[i] = total;
+    }
+    for(SamplingMethod method : {SamplingMethod::BinarySearch, SamplingMethod::Alias, SamplingMethod::Universal}){
+        SelectionDistribution distribution;
+        buildSelectionDistribution(cumulativeWeights.data(), size, method, distribution);
+        const int draws = 200000;
+        std::vector<int> winners(draws);
+        sampleSelectionDistribution(distribution, winners.data(), draws, engine);
+        std::vector<int> counts(size);
+        for(int winner : winners){
+            CHECK(winner>=0 && winner<size);
+            counts[winner]++;
+        }
+        for(int i=0;i<size;++i){
+            double p = (cumulativeWeights[i] - (i ? cumulativeWeights[i - 1] : 0.f))/total;
+            double expected = draws*p;
+            if(method==SamplingMethod::Universal){
+                //Evenly spaced pointers give each index its expected count, rounded either way
+                CHECK(counts[i]==int(std::floor(expected)) || counts[i]==int(std::ceil(expected)));
+            } else {
+                CHECK(std::fabs(counts[i] - expected)<=5*std::sqrt(expected*(1 - p)) + 1);
+            }
+        }
+    }
+}
+
+//The probability that the individual of rank rank, 0 being the best, wins a tournament of tournamentSize distinct contestants out of
+//populationSize: it's drawn, and the tournamentSize - 1 others are all drawn among the populationSize - 1 - rank worse ones
+double tournamentProbability(int populationSize, int tournamentSize, int rank){
+    double probability = double(tournamentSize)/populationSize;
+    for(int other=1;other<tournamentSize;++other){
+        probability *= double(populationSize - rank - other)/(populationSize - other);
+    }
+    return std::max(probability, 0.);
+}
+
+//Winners must follow the distribution of tournaments of exactly tournamentSize distinct contestants, within 5 standard deviations. With
+//populationSize = tournamentSize + 1, that's only the best and second best ever winning: any duplicate contestant would let the worse ones win
+void checkTournaments(){
+    RandomEngine engine(21);
+    SelectionWorkspace workspace;
+    for(int populationSize : {3, 4, 6, 17, 20, 1000}){
+        for(int tournamentSize : {2, 3, 5, 16}){
+            if(tournamentSize>=populationSize){
+                continue;
+            }
+            std::vector<float> fitness(populationSize);
+            std::iota(fitness.begin(), fitness.end(), 0.f);
+            std::shuffle(fitness.begin(), fitness.end(), engine);
+            for(bool maximizeFitness : {true, false}){
+                const int draws = 100000;
+                std::vector<int> winners(draws);
+                workspace.reserve(populationSize);
+                tournamentRanking(populationSize, fitness.data(), maximizeFitness, tournamentSize, winners.data(), draws, workspace, engine);
+                std::vector<int> counts(populationSize);
+                for(int winner : winners){
+                    int rank = maximizeFitness ? populationSize - 1 - int(fitness[winner]) : int(fitness[winner]);
+                    counts[rank]++;
+                }
+                for(int rank=0;rank<populationSize;++rank){
+                    double p = tournamentProbability(populationSize, tournamentSize, rank);
+                    double expected = draws*p;
+                    CHECK(p>0 ? std::fabs(counts[rank] - expected)<=5*std::sqrt(expected*(1 - p)) + 1 : counts[rank]==0);
+                }
+            }
+        }
+    }
+}
+
+//A generational loop must stop allocating once its workspace has seen the population
+void checkSteadyStateAllocations(){
+    RandomEngine engine(3);
+    const int populationSize = 10000;
+    SelectionWorkspace workspace(populationSize);
+    std::vector<float> fitness(populationSize);
+    std::vector<int> winners(2*populationSize);
+    std::vector<int> tournamentWinners(populationSize);
+    SelectionRequest requests[] = {{SelectionKind::Linear, 1.5f, winners.data(), populationSize},
+                                   {SelectionKind::Tournament, 3, tournamentWinners.data(), populationSize}};
+    uint64_t bytes = 0;
+    for(int generation=0;generation<5;++generation){
+        for(float &value : fitness){
+            value = engine.uniformFloat();
+        }
+        rouletteRanking(populationSize, fitness.data(), winners.data(), 2*populationSize, workspace, engine, SamplingMethod::Alias);
+        rouletteRanking(populationSize, fitness.data(), winners.data(), 2*populationSize, workspace, engine, SamplingMethod::BinarySearch);
+        rouletteRanking(populationSize, fitness.data(), winners.data(), 2*populationSize, workspace, engine, SamplingMethod::Universal);
+        linearRanking(populationSize, fitness.data(), true, 1.5f, winners.data(), 2*populationSize, workspace, engine);
+        exponentialRanking(populationSize, fitness.data(), false, 0.05f, winners.data(), 2*populationSize, workspace, engine);
+        tournamentRanking(populationSize, fitness.data(), true, 4, winners.data(), 2*populationSize, workspace, engine);
+        selectBatch(populationSize, fitness.data(), true, requests, 2, workspace, engine);
+        if(!generation){
+            bytes = workspace.bytesAllocated();
+        }
+        CHECK(workspace.bytesAllocated()==bytes);
+    }
+}
+
+//Each request of a batch gets the winners the single selection would give from the same engine state
+void checkBatchMatchesSingleCalls(){
+    const int populationSize = 3000;
+    RandomEngine fill(4);
+    std::vector<float> fitness(populationSize);
+    for(float &value : fitness){
+        value = fill.uniformFloat();
+    }
+    std::vector<int> roulette(populationSize), linear(populationSize), exponential(populationSize);
+    SelectionRequest requests[] = {{SelectionKind::Roulette, 0, roulette.data(), populationSize, SamplingMethod::Alias},
+                                   {SelectionKind::Linear, 1.7f, linear.data(), populationSize, SamplingMethod::BinarySearch},
+                                   {SelectionKind::Exponential, 0.03f, exponential.data(), populationSize, SamplingMethod::Universal}};
+    SelectionWorkspace workspace(populationSize);
+    RandomEngine batchEngine(5);
+    selectBatch(populationSize, fitness.data(), false, requests, 3, workspace, batchEngine);
+    RandomEngine engine(5);
+    std::vector<int> winners(populationSize);
+    rouletteRanking(populationSize, fitness.data(), winners.data(), populationSize, workspace, engine, SamplingMethod::Alias);
+    CHECK(winners==roulette);
+    linearRanking(populationSize, fitness.data(), false, 1.7f, winners.data(), populationSize, workspace, engine, SamplingMethod::BinarySearch);
+    CHECK(winners==linear);
+    exponentialRanking(populationSize, fitness.data(), false, 0.03f, winners.data(), populationSize, workspace, engine, SamplingMethod::Universal);
+    CHECK(winners==exponential);
+}
+
+int main(){
+    checkFrequencies();
+    checkTournaments();
+    checkSteadyStateAllocations();
+    checkBatchMatchesSingleCalls();
+    return checkResult();
+}